@@ -1,5 +1,8 @@
 
 
+// this is needed for the linux specific calls like sched_setaffinity.
+#define _GNU_SOURCE
+
 // all the imports required by the program
 #include <stdio.h>
 #include <stdlib.h>
@@ -9,853 +12,6936 @@
 #include <sys/wait.h>
 #include <fcntl.h>
 #include <math.h>
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <limits.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <poll.h>
+#include <termios.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <sys/inotify.h>
+#include <ctype.h>
+#include <spawn.h>
 
 // defined macro to store the buffer size and delimiters.
 #define INPUT_BUFFER_SIZE 1024
-#define PROMPT_BUFFER_SIZE 1024
-#define PROMPT_DELIMITERS " \t\n\r\a"
+#define PROMPT_DELIMITERS " \t\r\a"
+#define OPERATOR_CHARACTERS "|&;()<>"
+#define MAX_BACKGROUND_PROCESSES 50
 
-// these are the varibales used to track background processIds.
-// and names to be used by & and fg operators/commands.
-int bgProcessListPointer = -1;
-long bgProcessIds[50];
-char *bgProcessNames[50];
-int isFgProcess = 0;
+// defined macro for the tokens of the lexer.
+#define TOKEN_WORD 0
+#define TOKEN_NEWLINE 1
+#define TOKEN_PIPE 2
+#define TOKEN_OR 3
+#define TOKEN_BACKGROUND 4
+#define TOKEN_AND 5
+#define TOKEN_SEMICOLON 6
+#define TOKEN_OPEN_PAREN 7
+#define TOKEN_CLOSE_PAREN 8
+#define TOKEN_LESS 9
+#define TOKEN_GREAT 10
+#define TOKEN_DOUBLE_GREAT 11
+#define TOKEN_LESS_AND 12
+#define TOKEN_GREAT_AND 13
+#define TOKEN_AND_GREAT 14
+#define TOKEN_AND_DOUBLE_GREAT 15
+#define TOKEN_IO_NUMBER 16
+#define TOKEN_ARITH 17
+#define TOKEN_END 18
 
-// these are the variables used to store the user input and the tokenized version of this input.
-char *userPrompt;
-char **userPromptList;
+// defined macro for the node types of the parsed tree and what left, right and extra are.
+#define NODE_NONE UINT32_MAX
+#define NODE_LITERAL 1    // left: offset of the string
+#define NODE_STATUS 2     // $? the exit status of the last command
+#define NODE_WORD 3       // left, right: range of the parts of a word with expansions
+#define NODE_COMMAND 4    // left, right: range of the assignments and words, extra: number of assignments
+#define NODE_PIPELINE 5   // left, right: range of the stages, extra: 1 if it is profiled
+#define NODE_AND 6        // left && right
+#define NODE_OR 7         // left || right
+#define NODE_LIST 8       // left, right: range of the commands run one after the other
+#define NODE_BACKGROUND 9 // left &
+#define NODE_SUBSHELL 10  // ( left )
+#define NODE_GROUP 11     // { left; }
+#define NODE_REDIRECT 12  // left: redirected node, right: REDIRECT_ type and fd << 8, extra: word of the target
+#define NODE_WATCH 13     // left: watched node, right, extra: range of the builtin words and command text
+#define NODE_VARIABLE 14  // $NAME, left: offset of the name
+#define NODE_ASSIGN 15    // NAME=value, left: offset of the name, right: word of the value
+#define NODE_IF 16        // if left then right else extra (NODE_NONE if there is no else)
+#define NODE_WHILE 17     // while left do right, extra is 1 for until
+#define NODE_FOR 18       // for left (offset of the name) in extra (word list) do right
+#define NODE_WORD_LIST 19 // left, right: range of words which can be empty
+#define NODE_ARITH 20     // $(( left )) used as a part of a word
+#define NODE_ARITH_COMMAND 21   // (( left ))
+#define NODE_ARITH_NUMBER 22    // left, right: low and high 32 bits of the number
+#define NODE_ARITH_UNARY 23     // right is the operator character applied to left
+#define NODE_ARITH_BINARY 24    // left and right with the ARITH_ operator in extra
+#define NODE_ARITH_CONDITION 25 // left ? right : extra
+#define NODE_ARITH_ASSIGN 26    // left: offset of the name, right: value, extra: ARITH_ operator of op=
+#define NODE_ARITH_INCREMENT 27 // left: offset of the name, right: ARITH_INCREMENT_ type
 
-// variables to store original stdin and stdout.
-int original_stdin;
-int original_stdout;
+// defined macro for the kinds of children checked when a tree is loaded from the cache.
+// a command is any node the executor can run.
+#define NODE_KIND_PART 0
+#define NODE_KIND_WORD 1
+#define NODE_KIND_COMMAND 2
+#define NODE_KIND_ARITH 3
 
-// this the function I am using to log messages to console.
-// it uses the error stream to console on terminal
-// even if other streams are redirected.
-void yash_logMessage(char *message)
-{
-  fprintf(stderr, "%s \n", message);
-}
+// defined macro for the operators of the arithmetic expansion, they are the index in
+// yash_arithOperators. ARITH_ASSIGN is the plain = of an assignment.
+#define ARITH_OR 0
+#define ARITH_AND 1
+#define ARITH_BIT_OR 2
+#define ARITH_BIT_XOR 3
+#define ARITH_BIT_AND 4
+#define ARITH_EQUAL 5
+#define ARITH_NOT_EQUAL 6
+#define ARITH_LESS_EQUAL 7
+#define ARITH_GREAT_EQUAL 8
+#define ARITH_SHIFT_LEFT 9
+#define ARITH_SHIFT_RIGHT 10
+#define ARITH_LESS 11
+#define ARITH_GREAT 12
+#define ARITH_ADD 13
+#define ARITH_SUBTRACT 14
+#define ARITH_MULTIPLY 15
+#define ARITH_DIVIDE 16
+#define ARITH_REMAINDER 17
+#define ARITH_ASSIGN 18
+#define ARITH_PRE_INCREMENT 0
+#define ARITH_PRE_DECREMENT 1
+#define ARITH_POST_INCREMENT 2
+#define ARITH_POST_DECREMENT 3
 
-/**
- * @brief Function to display the custom shell prompt.
- *
- * This function prints a custom shell prompt with colored characters and an emoji.
- * The prompt consists of the letters 'yash' in different colors followed by a bug emoji and a '$' sign.
- *
- * @note The function uses ANSI escape codes for color formatting.
- */
-void yash_prompt()
-{
-  // Set color for 'y' to red
-  printf("\033[0;31m");
-  printf("y");
+// defined macro for the type of redirection, N>&M and N<&M are both a duplicate
+// and become a close in the plan when the target is -. The _ALL types are &> and &>>
+// which redirect both stdout and stderr.
+#define REDIRECT_OUTPUT 1
+#define REDIRECT_APPEND 2
+#define REDIRECT_INPUT 3
+#define REDIRECT_DUPLICATE 4
+#define REDIRECT_OUTPUT_ALL 5
+#define REDIRECT_APPEND_ALL 6
+#define REDIRECT_CLOSE 7
+#define REDIRECT_MAX_FD 1023
 
-  // Set color for 'a' to green
-  printf("\033[0;32m");
-  printf("a");
+// defined macro for the compiled script cache, the magic and version are
+// written in the header of each cache file so stale formats are never loaded.
+#define SCRIPT_CACHE_MAGIC "YASHAST"
+#define SCRIPT_CACHE_VERSION 4
+#define SCRIPT_CACHE_SUFFIX ".ast"
 
-  // Set color for 's' to yellow
-  printf("\033[0;33m");
-  printf("s");
+// defined macro for the launch modifiers like @cpus=, @node=, @rlimit= and @cgroup=.
+#define MAX_LAUNCH_LIMITS 16
+#define MAX_NUMA_NODES 1024
+#define CGROUP_ROOT "/sys/fs/cgroup"
+// defined macro for the timeout builtin and the @deadline= modifier, the group
+// gets SIGKILL if it is still running this long after SIGTERM.
+#define TIMEOUT_KILL_AFTER_NANOS 2000000000LL
+#define TIMEOUT_EXIT_STATUS 124
+#define TIMEOUT_FAILED_STATUS 125
 
-  // Set color for 'h' to purple
-  printf("\033[0;35m");
-  printf("h");
+// defined macro for the onchange builtin, the events which count as a change
+// and the default debounce window used to coalesce a burst of changes.
+#define ONCHANGE_EVENTS (IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | \
+                         IN_MOVED_TO | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF)
+#define ONCHANGE_DEBOUNCE_NANOS 100000000LL
 
-  // Set color for the bug emoji and the '$' sign to white
-  printf("\033[0;37m");
-  printf("\U0001F4DF");
-  printf(" $ ");
+// defined macro for the audit log. The ring size must be a power of two,
+// the writer is woken up early when AUDIT_WAKE_BYTES are waiting in the ring.
+#define AUDIT_FILE_MAGIC "YASHAUD1"
+#define AUDIT_MAGIC_SIZE 8
+#define AUDIT_RING_SIZE (1 << 20)
+#define AUDIT_WAKE_BYTES (AUDIT_RING_SIZE / 4)
+#define AUDIT_MAX_RECORD_SIZE (64 * 1024)
+#define AUDIT_FLUSH_INTERVAL_MS 100
+#define AUDIT_SYNC_INTERVAL_MS 1000
+#define AUDIT_SYNC_BYTES (64 * 1024)
+#define AUDIT_RECORD_COMMAND 1
+#define AUDIT_RECORD_BACKGROUND 2
+#define AUDIT_RECORD_BACKGROUND_EXIT 3
+#define AUDIT_FLAG_TIMED_OUT 1
+#define AUDIT_FLAG_TRUNCATED 2
+#define AUDIT_FLAG_BUILTIN 4
 
-  // Reset color to default
-  printf("\033[0m");
-}
+// defined macro for the profile builtin, the most a relay moves with one splice, the
+// size of the pipes around a relay and the size of the command names printed in the report.
+#define PROFILE_SPLICE_SIZE (1 << 20)
+#define PROFILE_PIPE_SIZE (1 << 20)
+#define PROFILE_NAME_SIZE 25
 
-// this is the function which is used to get input from the terminal
-// using the fgets function.
-void yash_readPrompt(char **userPrompt)
+// defined macro for the prompt. The escapes of the template are in the order of the
+// PROMPT_ segment types which start at PROMPT_DIRECTORY, the default template is
+// the yash prompt with the git, exit status, duration and jobs segments.
+#define PROMPT_ESCAPES "dgetjl"
+#define PROMPT_LITERAL 0
+#define PROMPT_DIRECTORY 1
+#define PROMPT_GIT 2
+#define PROMPT_STATUS 3
+#define PROMPT_DURATION 4
+#define PROMPT_JOBS 5
+#define PROMPT_LOAD 6
+#define PROMPT_MAX_SEGMENTS 64
+#define PROMPT_SEGMENT_SIZE 256
+#define PROMPT_RENDER_SIZE 4096
+#define PROMPT_CACHE_SIZE 16
+// the prompt waits at most this long for the worker when the directory is new or
+// the HEAD or index of its repository changed since the segments were computed.
+#define PROMPT_WAIT_NANOS 50000000LL
+#define PROMPT_DEFAULT_TEMPLATE "%[0;31]y%[0;32]a%[0;33]s%[0;35]h%[0;37]\U0001F4DF%[0;36]%g%[0;31]%e%[0;33]%t%[0;35]%j%[0;37] $ %[0]"
+
+#ifndef MPOL_BIND
+#define MPOL_BIND 2
+#endif
+
+// this is the placement and limits requested by the launch modifiers of a command.
+// it is filled in the shell before fork and applied in the child before exec.
+typedef struct
 {
-  // I am getting the input from terminal and storing it in userPrompt char pointer
-  fgets(*userPrompt, sizeof(char) * INPUT_BUFFER_SIZE, stdin);
+  int hasCpus;
+  cpu_set_t cpus;
+  int hasNode;
+  unsigned long nodeMask[MAX_NUMA_NODES / (8 * sizeof(unsigned long))];
+  int hasNice;
+  int nice;
+  int limitCount;
+  int limitResources[MAX_LAUNCH_LIMITS];
+  struct rlimit limits[MAX_LAUNCH_LIMITS];
+  char cgroup[PATH_MAX];
+  int64_t deadline;
+} yash_launchSpec;
 
-  // here i am checking if the length of provided input is greater
-  // than zero and replace the last newLine character by null character.
-  long lengthOfPrompt = strlen(*userPrompt);
-  if (lengthOfPrompt > 0 && (*userPrompt)[lengthOfPrompt - 1] == '\n')
-  {
-    (*userPrompt)[lengthOfPrompt - 1] = '\0';
-  }
-}
+// this is the fixed part of an audit record, it is followed by the cwd and
+// then each argument as a uint32_t length and the bytes. The record is padded
+// to 8 bytes and length is the size of the whole record with padding.
+// status is the raw wait status or -1 if it is not known.
+typedef struct
+{
+  uint32_t length;
+  uint16_t type;
+  uint16_t flags;
+  uint32_t argc;
+  uint32_t cwdLength;
+  int64_t startTime;
+  int64_t duration;
+  int32_t pid;
+  int32_t status;
+} yash_auditRecordHeader;
 
-// this is the function which is used to process user input
-// basically it converts the prompt string to tokens seperated by provided delimiter
-// using strtok function.
-void yash_processUserPrompt(char **prompt, char ***list)
+// this is the state of the audit log. The shell is the only producer and
+// the writer thread the only consumer of the ring, head and tail only grow
+// and the position in the ring is taken with AUDIT_RING_SIZE - 1 as mask.
+typedef struct
 {
-  char *token;
-  long position = 0;
+  int fileDescriptor;
+  int wakeFD;
+  pthread_t writer;
+  char *ring;
+  _Atomic uint64_t head;
+  _Atomic uint64_t tail;
+  _Atomic int isStopping;
+} yash_auditLog;
 
-  // get tokens based on delimiters.
-  token = strtok(*prompt, PROMPT_DELIMITERS);
+// this is one token from the lexer, the text is not copied and
+// start and length point in the source which was lexed.
+typedef struct
+{
+  int type;
+  uint32_t start;
+  uint32_t length;
+  uint32_t line;
+} yash_token;
 
-  // for each token store that in the provided list
-  while (token != NULL)
-  {
-    (*list)[position] = token;
-    position++;
+// this is one node of the parsed prompt or script. The meaning of left, right and
+// extra depends on the type (see the NODE_ macros). Children are stored as indexes
+// and the lists of children are ranges in the lists array, so the tree has no pointers
+// and can be written to the cache and used from the mmap as it is.
+typedef struct
+{
+  uint32_t type;
+  uint32_t left;
+  uint32_t right;
+  uint32_t extra;
+} yash_node;
 
-    // here I am getting the next token
-    token = strtok(NULL, PROMPT_DELIMITERS);
-  }
+// this is the header of a compiled script image. The same layout is used on disk
+// in the cache, so loading a cached script is only an mmap and a check of the nodes.
+// The header is followed by the sections:
+//   nodes[nodeCount]      the nodes of the tree, a child always comes before its parent
+//   lists[listCount]      the ranges of node indexes used by the nodes
+//   strings[stringBytes]  NULL terminated strings used by the literal nodes
+typedef struct
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t nodeCount;
+  uint32_t listCount;
+  uint32_t stringBytes;
+  uint32_t root;
+  uint32_t reserved;
+  uint64_t device;
+  uint64_t inode;
+  uint64_t size;
+  int64_t mtimeSec;
+  int64_t mtimeNsec;
+} yash_scriptHeader;
 
-  // NULL terminate the list to ensure end of list.
-  (*list)[position] = NULL;
-}
+// this is the parsed form of a prompt or a script. When it is parsed the arrays are
+// malloc buffers which can grow, when it is loaded from the cache they point in the
+// mmap of the cache file and image is the mapping.
+typedef struct
+{
+  yash_node *nodes;
+  uint32_t nodeCount;
+  uint32_t nodeCapacity;
+  uint32_t *lists;
+  uint32_t listCount;
+  uint32_t listCapacity;
+  char *strings;
+  uint32_t stringBytes;
+  uint32_t stringCapacity;
+  uint32_t root;
+  void *image;
+  size_t imageSize;
+} yash_ast;
 
-// this is the function which is used to execute a particular linux command
-// it creates the args vector based on parameters passed and execute the command
-// using execvp under a child process so the parent process does not terminate.
-int yash_executeCommand(char *command, char **cmdArgs, int cmdArgsCount)
+// this is the state of the parser, it reads the tokens from position
+// and adds the nodes in the ast.
+typedef struct
 {
+  const char *source;
+  yash_token *tokens;
+  uint32_t tokenCount;
+  uint32_t position;
+  yash_ast *ast;
+  int hasError;
+  int isPrompt;
+  int isIncomplete;
+} yash_parser;
 
-  // create the args vector of size arguments length + 1
-  // extra length is for the NULL character required by execvp.
-  char *argsVector[cmdArgsCount + 1];
+// this is a child started by the shell which is being waited for. The arguments
+// are kept for the audit log and for the timeout report, they are NULL for a
+// child which runs a part of the tree like a subshell. processGroup is the group
+// which is signalled at the deadline.
+typedef struct
+{
+  pid_t pid;
+  pid_t processGroup;
+  int64_t deadline;
+  int64_t killAfter;
+  int64_t startTime;
+  int64_t startClock;
+  char **cmdArgs;
+  int cmdArgsCount;
+  int status;
+  int isTimedOut;
+} yash_child;
 
-  // iterate over the command arguments and store it in argsVector.
-  for (int args = 0; args < cmdArgsCount; args++)
-  {
-    argsVector[args] = cmdArgs[args];
-  }
+// this is the expanded arguments of a command, the arguments which are not
+// literals are built in memory and are freed with the arguments.
+typedef struct
+{
+  char **argv;
+  int argc;
+  char **owned;
+  int ownedCount;
+  char **environment;
+  int environmentCount;
+  int hasError;
+} yash_args;
 
-  // add the NULL character at the end
-  argsVector[cmdArgsCount] = NULL;
+// this is the state used to compile the text of an arithmetic expression into nodes.
+typedef struct
+{
+  yash_parser *parser;
+  const char *text;
+  uint32_t length;
+  uint32_t position;
+} yash_arithParser;
 
-  // create a child using fork
-  int child = fork();
+// this is a shell variable. A variable set by arithmetic keeps only the number and
+// the text is made when it is needed, so a counter in a loop is never converted.
+// value is NULL when the text is not made yet.
+typedef struct
+{
+  char *name;
+  char *value;
+  int64_t number;
+  int hasNumber;
+  int isExported;
+} yash_variable;
 
-  // check if there is some issue while creating the child
-  if (child == -1)
-  {
-    yash_logMessage("Error while creating child to execute a command.");
-    return -1;
-  }
+// this is a builtin which runs in the shell itself.
+typedef struct
+{
+  const char *name;
+  int (*function)(char **args, int argc);
+} yash_builtin;
 
-  // now in the child process execute the command using execvp
-  if (child == 0)
-  {
-    // checking if the execvp failed and printing error message.
-    if (execvp(command, argsVector) == -1)
-    {
-      yash_logMessage("Error while executing the command: Invalid command or arguments.");
-      return -1;
-    }
-  }
+// this is one redirection of a command after its target is expanded, fd is the
+// descriptor of the command which is redirected to the file or to targetFD.
+typedef struct
+{
+  int type;
+  int fd;
+  int targetFD;
+  const char *path;
+} yash_redirect;
 
-  int status;
+// this is the plan of the redirections of a command, in the order they are written.
+// it is built by the shell and applied only in the child before exec, so the fds
+// of the shell never change and any number of commands can be started with their
+// own redirections at the same time. The expanded targets are owned by words.
+typedef struct
+{
+  yash_redirect *redirects;
+  int count;
+  yash_args words;
+} yash_redirectPlan;
 
-  // parent waiting for child to terminate after execution of command.
-  waitpid(child, &status, 0);
+// this is the relay between two stages of a profiled pipeline. The stage before writes
+// in the pipe read by inFD and the stage after reads the pipe written by outFD. The
+// counters are updated by the relay thread and read by the report at any time.
+typedef struct
+{
+  int inFD;
+  int outFD;
+  int stopFD;
+  pthread_t thread;
+  int hasThread;
+  _Atomic uint64_t bytes;
+  _Atomic int64_t emptyNanos;
+  _Atomic int64_t fullNanos;
+  _Atomic int64_t endClock;
+} yash_pipeRelay;
 
-  // returning zero if everything is successfull
-  return 0;
-}
+// this is the state of a profiled pipeline, there is one relay between each two stages.
+typedef struct
+{
+  yash_pipeRelay *relays;
+  int relayCount;
+  char (*stageNames)[PROFILE_NAME_SIZE];
+  int stageCount;
+  int64_t startClock;
+  int stopFD;
+  pthread_t reporter;
+  int hasReporter;
+  struct sigaction previousAction;
+} yash_profile;
 
-// this is the function used to open a new session of the terminal.
-// this uses x-terminal-emulator command to execute the shell file.
-// internally its calling yash_executeCommand function
-void yash_openNewSession()
+// this is a segment of the compiled prompt, a literal is the range offset, length
+// of the literal text of the prompt and the other types are rendered each time.
+typedef struct
 {
-  char *args[] = {"x-terminal-emulator", "-e", "./yash"};
-  yash_executeCommand(args[0], args, 3);
-}
+  int type;
+  size_t offset;
+  size_t length;
+} yash_promptSegment;
 
-// this is the function used to execute the command in background
-// when & operator is used basically is creates a new child for the
-// command with a different session and the parent is not waiting for it.
-// also I am storing its pid for future use by other commands.
-int yash_execute_in_bg(char *command, char **cmdArgs, int cmdArgsCount)
+// this is the git segment of a directory computed by the prompt worker. The git directory
+// and the mtimes of its HEAD and index tell the prompt when a command changed the repository.
+typedef struct
 {
-  // create the args vector of size arguments length + 1
-  // extra length is for the NULL character required by execvp.
-  char *argsVector[cmdArgsCount + 1];
+  char directory[PATH_MAX];
+  char git[PROMPT_SEGMENT_SIZE];
+  char gitDirectory[PATH_MAX];
+  struct timespec headTime;
+  struct timespec indexTime;
+  int64_t updatedAt;
+} yash_promptCacheEntry;
 
-  // iterate over the command arguments and store it in argsVector.
-  for (int args = 0; args < cmdArgsCount; args++)
-  {
-    argsVector[args] = cmdArgs[args];
-  }
+// this is the state of the prompt worker thread. The prompt puts the directory in
+// requestedDirectory and the worker puts the results in the cache, both with the lock.
+// done is signalled each time the worker has updated the cache.
+typedef struct
+{
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  pthread_cond_t done;
+  pthread_t thread;
+  int isStarted;
+  int hasRequest;
+  char requestedDirectory[PATH_MAX];
+  yash_promptCacheEntry cache[PROMPT_CACHE_SIZE];
+  char load[PROMPT_SEGMENT_SIZE];
+} yash_promptWorker;
 
-  // add the NULL character at the end
-  argsVector[cmdArgsCount] = NULL;
+// these are the varibales used to track background processIds.
+// and names to be used by & and fg operators/commands.
+int bgProcessListPointer = -1;
+long bgProcessIds[MAX_BACKGROUND_PROCESSES];
+char *bgProcessNames[MAX_BACKGROUND_PROCESSES];
+int isFgProcess = 0;
 
-  // creating the child using fork
-  int child = fork();
-  if (child < 0)
-  {
-    yash_logMessage("Error creating child for bg process.");
-    return -1;
-  }
+// the arguments and the start time of each background process are kept for the
+// record of its end in the audit log, which is written when fg or wait reaps it.
+char **bgProcessArgs[MAX_BACKGROUND_PROCESSES];
+int bgProcessArgCounts[MAX_BACKGROUND_PROCESSES];
+int64_t bgProcessStartTimes[MAX_BACKGROUND_PROCESSES];
+int64_t bgProcessStartClocks[MAX_BACKGROUND_PROCESSES];
 
-  // in the child process create a new session using setsid and
-  //  then call execute with the particular command
-  if (child == 0)
-  {
-    if (setsid() == -1)
-    {
-      yash_logMessage("Error starting a session for new child process for bg command.");
-      return -1;
-    }
-    execvp(command, argsVector);
-  }
+// this is the variable used to store the user input.
+char *userPrompt;
 
-  // now add the pid of bg process in the global array.
-  bgProcessListPointer++;
-  bgProcessIds[bgProcessListPointer] = child;
+// this is the exit status of the last command, used by $?, && and ||.
+int lastExitStatus = 0;
 
-  // below code prints the process id with the process name for the process
-  // which will be running in background. also store that string in global variable for future use.
-  char childID[50];
-  sprintf(childID, "%d", child);
+// this is the duration of the last prompt which ran a command and when it finished,
+// in monotonic nanoseconds, for the prompt.
+int64_t lastCommandNanos = 0;
+int64_t lastCommandEnd = 0;
 
-  char *processDetails = malloc(sizeof(char) * 8024);
-  processDetails = strcpy(processDetails, "[");
-  processDetails = strcat(processDetails, childID);
-  processDetails = strcat(processDetails, "] ");
+// this is the compiled prompt and the segments written for the last prompt, which
+// Ctrl-C writes again. promptVectorCount is 0 while the prompt is compiled and rendered.
+char *promptTemplate = NULL;
+char *promptLiterals = NULL;
+yash_promptSegment *promptSegments = NULL;
+int promptSegmentCount = 0;
+int promptHasWorkerSegment = 0;
+char promptRendered[PROMPT_RENDER_SIZE];
+struct iovec promptVector[PROMPT_MAX_SEGMENTS];
+volatile sig_atomic_t promptVectorCount = 0;
+yash_promptWorker promptWorker = {.lock = PTHREAD_MUTEX_INITIALIZER, .wake = PTHREAD_COND_INITIALIZER};
 
-  for (int args = 0; args < cmdArgsCount; args++)
-  {
-    processDetails = strcat(processDetails, cmdArgs[args]);
-  }
+// this is the hash table of the shell variables, it uses open addressing
+// and the capacity is always a power of two.
+yash_variable *variables = NULL;
+size_t variableCapacity = 0;
+size_t variableCount = 0;
 
-  bgProcessNames[bgProcessListPointer] = processDetails;
+// these are the variables used by the loops. The levels are set by break and
+// continue and make the lists stop until the loop which they belong to is reached.
+// isLoopInterrupted is set by Ctrl-C to stop the loops of the prompt.
+int loopDepth = 0;
+int breakLevels = 0;
+int continueLevels = 0;
+volatile sig_atomic_t isLoopInterrupted = 0;
 
-  yash_logMessage("Background Process:");
-  yash_logMessage(processDetails);
+// these are the operators of the arithmetic expansion with their precedence, the
+// operators with two characters come before the ones they start with.
+const char *yash_arithOperators[] = {"||", "&&", "|", "^", "&", "==", "!=", "<=", ">=", "<<", ">>",
+                                     "<", ">", "+", "-", "*", "/", "%"};
+const int yash_arithPrecedence[] = {1, 2, 3, 4, 5, 6, 6, 7, 7, 8, 8, 7, 7, 9, 9, 10, 10, 10};
 
-  return 0;
-}
+// this is the pipeline being profiled, its relays are closed in the copies of the shell
+// started for its stages. profileSignalFD is written by the SIGUSR1 handler to ask the
+// reporter thread for a report.
+yash_profile *activeProfile = NULL;
+int profileSignalFD = -1;
 
-// this is the function I am using to validate the commands and the special characters
-// as per the rules defined in the assignment.
-int yash_validate_prompt(char ***prompList)
-{
-  // defining variables to track the count of arguments and
-  // special characters.
-  int counter = 0;
-  int startPointer = 0;
-  int endPointer = 0;
-  int hashCount = 0;
-  int pipeCount = 0;
-  int conditionalCount = 0;
-  int sequentialCount = 0;
-  // now to each token I am checking for each special character
-  while ((*prompList)[counter] != NULL)
-  {
-    // if character is # I am increasing the hash counter and checking how
-    // many arguments are there in the command before the # and if its greater then 5 or less than 1
-    // I am printing error.
-    if (strcmp((*prompList)[counter], "#") == 0)
-    {
-      hashCount++;
-      endPointer = counter;
-      int offset = endPointer - startPointer;
-      if (offset > 5 || offset < 1)
-      {
-        yash_logMessage("Error: Command arguments cannot be greater then 5 or less than 1");
-        return -1;
-      }
-      startPointer = counter + 1;
-    }
-    // similar to # in | also I am storing the number of pipes and then checking if the
-    // arguments count is valid for command before |
-    else if (strcmp((*prompList)[counter], "|") == 0)
-    {
+// this is the flag set by Ctrl-C to stop the watch and onchange builtins.
+volatile sig_atomic_t isWatchInterrupted = 0;
 
-      pipeCount++;
-      endPointer = counter;
-      int offset = endPointer - startPointer;
-      if (offset > 5 || offset < 1)
-      {
-        yash_logMessage("Error: Command arguments cannot be greater then 5 or less than 1");
-        return -1;
-      }
-      startPointer = counter + 1;
-    }
-    // for the && and || also I am storing the count of operator and checking the
-    // number of arguments in the command if they are valid or not.
-    else if (strcmp((*prompList)[counter], "&&") == 0 ||
-             strcmp((*prompList)[counter], "||") == 0)
-    {
-      conditionalCount++;
-      endPointer = counter;
-      int offset = endPointer - startPointer;
-      if (offset > 5 || offset < 1)
-      {
-        yash_logMessage("Error: Command arguments cannot be greater then 5 or less than 1");
-        return -1;
-      }
-      startPointer = counter + 1;
-    }
-    // for the >, >> and < also I am storing the count of operator and checking the
-    // number of arguments in the command if they are valid or not.
-    else if (strcmp((*prompList)[counter], ">") == 0 ||
-             strcmp((*prompList)[counter], ">>") == 0 ||
-             strcmp((*prompList)[counter], "<") == 0)
-    {
-      endPointer = counter;
-      int offset = endPointer - startPointer;
-      if (offset > 5 || offset < 1)
-      {
-        yash_logMessage("Error: Command arguments cannot be greater then 5 or less than 1");
-        return -1;
-      }
-      startPointer = counter + 1;
-    }
-    // for the ; also I am storing the count of operator and checking the
-    // number of arguments in the command if they are valid or not.
-    else if (strcmp((*prompList)[counter], ";") == 0)
-    {
-      sequentialCount++;
-      endPointer = counter;
-      int offset = endPointer - startPointer;
-      if (offset > 5 || offset < 1)
-      {
-        yash_logMessage("Error: Command arguments cannot be greater then 5 or less than 1");
-        return -1;
-      }
-      startPointer = counter + 1;
-    }
-    counter++;
-  }
+// this is the deadline of the pipeline being started in monotonic nanoseconds,
+// it is set by the @deadline= modifier and shared by all the stages of the pipeline.
+// zero means there is no deadline.
+int64_t pipelineDeadline = 0;
 
-  // now if the token is a null character
-  // means its the last command or the only command in prompt
-  // In this also i am checking the number of arguments if they are valid or not.
-  if ((*prompList)[counter] == NULL)
-  {
-    endPointer = counter;
-    int offset = endPointer - startPointer;
-    if (offset > 5 || offset < 1)
-    {
-      yash_logMessage("Error: Command arguments cannot be greater then 5 or less than 1");
-      return -1;
-    }
-  }
+// this is the process group of the pipeline being started when it has a deadline, all
+// its stages join it so the deadline stops the whole pipeline and it can get the terminal.
+// -1 means the stages stay in the group of the shell and 0 that the next stage starts it.
+pid_t pipelineGroup = -1;
 
-  // now in this I am checking if the number of special characters are
-  // as per the requirements given in the assignment and printing error
-  // message if they are not aligned.
-  if (hashCount > 5)
-  {
-    yash_logMessage("Error: Max 5 contactenation operations are allowed");
-    return -1;
-  }
+// this is the audit log of the executed commands, enabled by --audit FILE
+// or the YASH_AUDIT_LOG environment variable.
+yash_auditLog auditLog;
+int isAuditEnabled = 0;
+int isAuditDirect = 0;
 
-  if (pipeCount > 6)
-  {
-    yash_logMessage("Error: Max 6 piping operations are allowed");
-    return -1;
-  }
+// this flag is used to turn off the compiled script cache
+// set by --no-cache option or YASH_NO_CACHE environment variable.
+int isScriptCacheDisabled = 0;
+
+// this the function I am using to log messages to console.
+// it uses the error stream to console on terminal
+// even if other streams are redirected.
+void yash_logMessage(char *message)
+{
+  fprintf(stderr, "%s \n", message);
+}
 
-  if (conditionalCount > 5)
+// this is the function which is used to get input from the terminal
+// using the fgets function. it returns -1 when the input is closed.
+int yash_readPrompt(char **userPrompt)
+{
+  // I am getting the input from terminal and storing it in userPrompt char pointer
+  if (fgets(*userPrompt, sizeof(char) * INPUT_BUFFER_SIZE, stdin) == NULL)
   {
-    yash_logMessage("Error: Max 5 conditional operations are allowed");
     return -1;
   }
 
-  if (sequentialCount > 4)
+  // here i am checking if the length of provided input is greater
+  // than zero and replace the last newLine character by null character.
+  long lengthOfPrompt = strlen(*userPrompt);
+  if (lengthOfPrompt > 0 && (*userPrompt)[lengthOfPrompt - 1] == '\n')
   {
-    yash_logMessage("Error: Max 5 sequential operations are allowed");
-    return -1;
+    (*userPrompt)[lengthOfPrompt - 1] = '\0';
   }
-
   return 0;
 }
 
-// this is the function used to do the cleanup task by freeing memory and closing fds
-void yash_cleanUp()
+// this is the function used to add a token in the list of tokens, the list grows when needed.
+void yash_addToken(yash_token **tokens, uint32_t *tokenCount, uint32_t *capacity,
+                   int type, uint32_t start, uint32_t length, uint32_t line)
 {
-
-  close(original_stdin);
-  close(original_stdout);
-
-  free(userPrompt);
-  free(userPromptList);
+  if (*tokenCount == *capacity)
+  {
+    *capacity *= 2;
+    *tokens = realloc(*tokens, sizeof(yash_token) * *capacity);
+  }
+  (*tokens)[*tokenCount] = (yash_token){type, start, length, line};
+  (*tokenCount)++;
 }
 
-// this is the function which execute the shell loop
-// it stays in loop for the time the shell is active
-// it prints the prompt and wait for the user input
-// and then act accordingly based on the input.
-void yash_loop()
+// this is the function used to find the paren which closes the one at the given position,
+// it returns UINT32_MAX if there is none.
+uint32_t yash_matchParen(const char *source, uint32_t sourceSize, uint32_t position)
 {
-
-  // here the shell loop starts
-  do
+  int depth = 0;
+  for (; position < sourceSize; position++)
   {
+    depth += source[position] == '(';
+    depth -= source[position] == ')';
+    if (depth == 0)
+    {
+      return position;
+    }
+  }
+  return UINT32_MAX;
+}
 
-    // I am using fflush to fush all the streams before taking prompts.
-    fflush(NULL);
-
-    // init the variables to store input and tokens.
-    userPrompt = malloc(sizeof(char) * INPUT_BUFFER_SIZE);
-    userPromptList = malloc(sizeof(char) * PROMPT_BUFFER_SIZE);
+// this is the function used by the lexer to free the tokens when the source can not be
+// split, the error is printed only if the source is complete.
+int yash_lexError(yash_token **tokens, const char *message, uint32_t line, int isPrompt)
+{
+  free(*tokens);
+  *tokens = NULL;
+  if (isPrompt)
+  {
+    return -2;
+  }
+  fprintf(stderr, "Error: %s %u \n", message, line);
+  return -1;
+}
 
-    // this is the pipe variables used to redirect the
-    // input and output streams based on special characters
-    // further I am also storing the stdin and stdout stream so I can reset it back
-    // to take input from or show output on terminal.
-    int pipeFD[2], prev_pipeFD = STDIN_FILENO;
-    original_stdin = dup(STDIN_FILENO);
-    original_stdout = dup(STDOUT_FILENO);
+// this is the lexer used for both the prompt and the script files. It splits the source
+// into words and operators, the operators do not need spaces around them.
+// text inside single or double quotes and characters after a backslash are part of the
+// word, the quotes are removed later when the word is compiled.
+// a # at the start of a line is a comment, anywhere else it is the concatenation operator.
+// $(( )) is kept in the word and (( )) is one token with the expression between the parens.
+// it returns -1 if there is an unterminated quote or paren, or -2 without printing the
+// error if isPrompt is set, so the prompt can ask for the next line.
+int yash_lex(const char *source, uint32_t sourceSize, yash_token **tokens, uint32_t *tokenCount, int isPrompt)
+{
+  uint32_t capacity = 64;
+  uint32_t position = 0;
+  uint32_t line = 1;
+  int isLineStart = 1;
 
-    // this is the function used to write a shell specific prompt
-    // which tells the user that shell is asking for the prompt.
-    yash_prompt();
+  *tokens = malloc(sizeof(yash_token) * capacity);
+  *tokenCount = 0;
 
-    // this function is used to get the prompt from the using from at the stdin stream.
-    yash_readPrompt(&userPrompt);
+  while (position < sourceSize)
+  {
+    char character = source[position];
 
-    // if the length is equal to zero just continue the loop skipping all the processing
-    // again asking for a valid input
-    if (strlen(userPrompt) == 0)
+    // skipping the delimiters between the tokens and the escaped new lines.
+    if (strchr(PROMPT_DELIMITERS, character) != NULL)
     {
-      yash_cleanUp();
+      position++;
+      continue;
+    }
+    if (character == '\\' && position + 1 < sourceSize && source[position + 1] == '\n')
+    {
+      position += 2;
+      line++;
       continue;
     }
 
-    // this funtion converts the user prompt into set of token splitted by space
-    // further these tokens are stored in the userPromptList passed.
-    yash_processUserPrompt(&userPrompt, &userPromptList);
-
-    // now after getting the input and converting then to tokens
-    // these tokens are passed to a validation function which checks if the
-    // commands and special character are as per the requirements given in the assignment
-    // regarding length of arguments and the count of special characters.
-    int isValid = yash_validate_prompt(&userPromptList);
-
-    // if there is some issue with the prompt -1 will be returned from above function
-    // an the further execution is terminated and the loop is continue to get correct input
-    // from user
-    if (isValid == -1)
+    if (character == '\n')
     {
-      yash_cleanUp();
+      yash_addToken(tokens, tokenCount, &capacity, TOKEN_NEWLINE, position, 1, line);
+      position++;
+      line++;
+      isLineStart = 1;
       continue;
     }
 
-    // now if the prompt is newt which is for opening new terminal session
-    // it execute the specific function to open new terminal and continue the
-    // loop to get next prompt.
-    if (strcmp(userPromptList[0], "newt") == 0)
+    if (character == '#' && isLineStart)
     {
-      yash_openNewSession();
-      yash_cleanUp();
+      while (position < sourceSize && source[position] != '\n')
+      {
+        position++;
+      }
       continue;
     }
+    isLineStart = 0;
 
-    // if the prompt is fg then the shell will start waiting
-    // for the latest bg process.
-    // if there is no bg process it will print error message.
-    if (strcmp(userPromptList[0], "fg") == 0)
+    // here I am checking the operators, the longest operator is taken first.
+    if (character == '(' && position + 1 < sourceSize && source[position + 1] == '(')
     {
-      if (bgProcessListPointer == -1)
+      uint32_t end = yash_matchParen(source, sourceSize, position);
+      if (end == UINT32_MAX)
       {
-        yash_logMessage("No Background Process Exist.");
+        return yash_lexError(tokens, "Unterminated (( on line", line, isPrompt);
       }
-      else
+      yash_addToken(tokens, tokenCount, &capacity, TOKEN_ARITH, position + 1, end - position - 1, line);
+      for (; position <= end; position++)
       {
-        isFgProcess = 1;
-        int status;
-        yash_logMessage("Foreground Process: ");
-        yash_logMessage(bgProcessNames[bgProcessListPointer]);
-
-        // wait for lastest process executing in background.
-        waitpid(bgProcessIds[bgProcessListPointer], &status, 0);
-
-        bgProcessIds[bgProcessListPointer] = -1;
-        bgProcessListPointer--;
-        isFgProcess = 0;
+        line += source[position] == '\n';
       }
-
-      yash_cleanUp();
       continue;
     }
-
-    // these are the variables used to keep track of the command's
-    // start, end and count while iterating over each token of input
-    long commandStartPointer = 0;
-    long commandEndPointer = 0;
-    long commandsCounter = 0;
-
-    long iterator = 0;
-    int EOA = -1;
-
-    // this is used to track which was the lastSpecialCharacter which was executed.
-    char *lastSpecialCharacter = "";
-
-    // this is used to track the count of hash for processing the logic
-    int lastHashReplacement = -1;
-
-    // these are the variables used by the conditional operators.
-    int isLastEndValid = 0;
-    int isLastOrValid = -1;
-
-    // now here I am iterating in while for each token got from user prompt
-    while (EOA == -1)
+    if (strchr(OPERATOR_CHARACTERS, character) != NULL)
     {
+      char next = position + 1 < sourceSize ? source[position + 1] : '\0';
+      int type;
+      uint32_t length = 1;
 
-      // as the token list is NULL terminated if NULL is encountered while execution
-      // then I am just updating the end pointer and count and exiting from the loop.
-      // last command is executed outside the loop.
-      if (userPromptList[iterator] == NULL)
+      if (character == '|')
       {
-        commandEndPointer = iterator - 1;
-        commandsCounter++;
-        EOA = 1;
-        continue;
+        type = next == '|' ? TOKEN_OR : TOKEN_PIPE;
       }
-      // if a special character # is encountered then I am using the cat to output
-      // content of each file seperated by #. As cat works the same as per the requirement
-      // in the assignment.
-      else if (strcmp(userPromptList[iterator], "#") == 0)
+      else if (character == '&' && next == '>')
       {
-        // here i am storing the last executed character.
-        lastSpecialCharacter = "#";
-
-        // if its the first command I am adding cat command in the start followed by file names.
-        if (commandsCounter == 0)
-        {
-          userPromptList[iterator] = userPromptList[iterator - 1];
-          userPromptList[iterator - 1] = "cat";
-        }
-        else
-        {
-          // here i am appending other file names to create the cat command structure
-          if (lastHashReplacement == -1)
-          {
-            userPromptList[iterator] = userPromptList[iterator + 1];
-            lastHashReplacement = iterator;
-          }
-          else
-          {
-            userPromptList[lastHashReplacement + 1] = userPromptList[iterator + 1];
-            lastHashReplacement++;
-          }
+        int isAppend = position + 2 < sourceSize && source[position + 2] == '>';
+        type = isAppend ? TOKEN_AND_DOUBLE_GREAT : TOKEN_AND_GREAT;
+      }
+      else if (character == '&')
+      {
+        type = next == '&' ? TOKEN_AND : TOKEN_BACKGROUND;
+      }
+      else if (character == '>')
+      {
+        type = next == '>' ? TOKEN_DOUBLE_GREAT : next == '&' ? TOKEN_GREAT_AND : TOKEN_GREAT;
+      }
+      else if (character == '<')
+      {
+        type = next == '&' ? TOKEN_LESS_AND : TOKEN_LESS;
+      }
+      else if (character == ';')
+      {
+        type = TOKEN_SEMICOLON;
+      }
+      else if (character == '(')
+      {
+        type = TOKEN_OPEN_PAREN;
+      }
+      else
+      {
+        type = TOKEN_CLOSE_PAREN;
+      }
+
+      if (type == TOKEN_AND_DOUBLE_GREAT)
+      {
+        length = 3;
+      }
+      else if (type == TOKEN_OR || type == TOKEN_AND || type == TOKEN_DOUBLE_GREAT ||
+               type == TOKEN_LESS_AND || type == TOKEN_GREAT_AND || type == TOKEN_AND_GREAT)
+      {
+        length = 2;
+      }
+      yash_addToken(tokens, tokenCount, &capacity, type, position, length, line);
+      position += length;
+      continue;
+    }
+
+    // this is a word, it ends at a delimiter or an operator which is not quoted.
+    uint32_t start = position;
+    uint32_t startLine = line;
+    char quote = '\0';
+    while (position < sourceSize)
+    {
+      character = source[position];
+      if (quote != '\'' && character == '$' && position + 2 < sourceSize &&
+          source[position + 1] == '(' && source[position + 2] == '(')
+      {
+        // the arithmetic expansion can have operators and spaces so it
+        // is taken until its closing paren.
+        uint32_t end = yash_matchParen(source, sourceSize, position + 1);
+        if (end == UINT32_MAX)
+        {
+          return yash_lexError(tokens, "Unterminated $(( on line", startLine, isPrompt);
+        }
+        for (; position < end; position++)
+        {
+          line += source[position] == '\n';
+        }
+      }
+      else if (quote == '\0')
+      {
+        if (strchr(PROMPT_DELIMITERS, character) != NULL || character == '\n' ||
+            strchr(OPERATOR_CHARACTERS, character) != NULL)
+        {
+          break;
+        }
+        if (character == '\'' || character == '"')
+        {
+          quote = character;
         }
-        commandsCounter++;
+        else if (character == '\\' && position + 1 < sourceSize)
+        {
+          position++;
+        }
+      }
+      else if (quote == '"' && character == '\\' && position + 1 < sourceSize)
+      {
+        position++;
+      }
+      else if (character == quote)
+      {
+        quote = '\0';
+      }
+
+      if (source[position] == '\n')
+      {
+        line++;
+      }
+      position++;
+    }
+
+    if (quote != '\0')
+    {
+      return yash_lexError(tokens, "Unterminated quote on line", startLine, isPrompt);
+    }
+
+    // a number right before < or > is the fd of the redirection like in 2>file.
+    int type = TOKEN_WORD;
+    if (position < sourceSize && (source[position] == '<' || source[position] == '>') &&
+        strspn(source + start, "0123456789") == position - start)
+    {
+      type = TOKEN_IO_NUMBER;
+    }
+    yash_addToken(tokens, tokenCount, &capacity, type, start, position - start, startLine);
+  }
+
+  yash_addToken(tokens, tokenCount, &capacity, TOKEN_END, position, 0, line);
+  return 0;
+}
+
+// this is the function used to add a node in the tree, it returns the index of the node.
+uint32_t yash_addNode(yash_ast *ast, uint32_t type, uint32_t left, uint32_t right, uint32_t extra)
+{
+  if (ast->nodeCount == ast->nodeCapacity)
+  {
+    ast->nodeCapacity = ast->nodeCapacity == 0 ? 64 : ast->nodeCapacity * 2;
+    ast->nodes = realloc(ast->nodes, sizeof(yash_node) * ast->nodeCapacity);
+  }
+  ast->nodes[ast->nodeCount] = (yash_node){type, left, right, extra};
+  ast->nodeCount++;
+  return ast->nodeCount - 1;
+}
+
+// this is the function used to add a range of node indexes in the lists,
+// it returns the index of the first one.
+uint32_t yash_addList(yash_ast *ast, const uint32_t *items, uint32_t count)
+{
+  while (ast->listCount + count > ast->listCapacity)
+  {
+    ast->listCapacity = ast->listCapacity == 0 ? 64 : ast->listCapacity * 2;
+    ast->lists = realloc(ast->lists, sizeof(uint32_t) * ast->listCapacity);
+  }
+  if (count > 0)
+  {
+    memcpy(ast->lists + ast->listCount, items, sizeof(uint32_t) * count);
+  }
+  ast->listCount += count;
+  return ast->listCount - count;
+}
+
+// this is the function used to add a string in the string pool, it returns its offset.
+uint32_t yash_addString(yash_ast *ast, const char *text, uint32_t length)
+{
+  while (ast->stringBytes + length + 1 > ast->stringCapacity)
+  {
+    ast->stringCapacity = ast->stringCapacity == 0 ? 256 : ast->stringCapacity * 2;
+    ast->strings = realloc(ast->strings, ast->stringCapacity);
+  }
+  memcpy(ast->strings + ast->stringBytes, text, length);
+  ast->strings[ast->stringBytes + length] = '\0';
+  ast->stringBytes += length + 1;
+  return ast->stringBytes - length - 1;
+}
+
+// this is the function used to free the tree, either the mmap of the cache or the buffers.
+void yash_freeAst(yash_ast *ast)
+{
+  if (ast->image != NULL)
+  {
+    munmap(ast->image, ast->imageSize);
+  }
+  else
+  {
+    free(ast->nodes);
+    free(ast->lists);
+    free(ast->strings);
+  }
+  memset(ast, 0, sizeof(*ast));
+  ast->root = NODE_NONE;
+}
+
+// this is the function used to add an index in a temporary list used while parsing.
+void yash_pushIndex(uint32_t **items, uint32_t *count, uint32_t *capacity, uint32_t item)
+{
+  if (*count == *capacity)
+  {
+    *capacity = *capacity == 0 ? 8 : *capacity * 2;
+    *items = realloc(*items, sizeof(uint32_t) * *capacity);
+  }
+  (*items)[*count] = item;
+  (*count)++;
+}
+
+// this is the function used to get the current token of the parser.
+const yash_token *yash_peekToken(yash_parser *parser)
+{
+  return &parser->tokens[parser->position];
+}
+
+// this is the function used to check if the current token is the given word without quotes,
+// it is used for the reserved words like { and } and for the builtins parsed specially.
+int yash_isWordToken(yash_parser *parser, const char *text)
+{
+  const yash_token *token = yash_peekToken(parser);
+  return token->type == TOKEN_WORD && token->length == strlen(text) &&
+         strncmp(parser->source + token->start, text, token->length) == 0;
+}
+
+// this is the function used to print the syntax error, only the first error is printed.
+void yash_syntaxError(yash_parser *parser)
+{
+  if (parser->hasError)
+  {
+    return;
+  }
+  parser->hasError = 1;
+
+  // a prompt which ends in the middle of a command continues on the next line.
+  const yash_token *token = yash_peekToken(parser);
+  if (token->type == TOKEN_END && parser->isPrompt)
+  {
+    parser->isIncomplete = 1;
+  }
+  else if (token->type == TOKEN_END)
+  {
+    fprintf(stderr, "Error: Syntax error, unexpected end of input on line %u \n", token->line);
+  }
+  else if (token->type == TOKEN_NEWLINE)
+  {
+    fprintf(stderr, "Error: Syntax error, unexpected new line on line %u \n", token->line);
+  }
+  else
+  {
+    fprintf(stderr, "Error: Syntax error near '%.*s' on line %u \n",
+            (int)token->length, parser->source + token->start, token->line);
+  }
+}
+
+// this is the function used to skip the new lines where a command can continue
+// like after && or | and between the commands of a list.
+void yash_skipNewLines(yash_parser *parser)
+{
+  while (yash_peekToken(parser)->type == TOKEN_NEWLINE)
+  {
+    parser->position++;
+  }
+}
+
+// this is the function used to get the length of a variable name at the start of text.
+uint32_t yash_nameLength(const char *text, uint32_t length)
+{
+  uint32_t nameLength = 0;
+  while (nameLength < length && (isalpha((unsigned char)text[nameLength]) || text[nameLength] == '_' ||
+                                 (nameLength > 0 && isdigit((unsigned char)text[nameLength]))))
+  {
+    nameLength++;
+  }
+  return nameLength;
+}
+
+uint32_t yash_compileArithmetic(yash_parser *parser, const char *text, uint32_t length);
+
+// this is the function used to compile the expansion which starts with $ at index of the
+// raw word: $?, $NAME, ${NAME} or $(( )). The index of its last character is stored in end.
+// it returns NODE_NONE if the $ does not start an expansion and is a normal character.
+uint32_t yash_compileExpansion(yash_parser *parser, const char *raw, uint32_t length, uint32_t index, uint32_t *end)
+{
+  const char *text = raw + index + 1;
+  uint32_t left = length - index - 1;
+
+  if (text[0] == '?')
+  {
+    *end = index + 1;
+    return yash_addNode(parser->ast, NODE_STATUS, 0, 0, 0);
+  }
+
+  // the expression of $(( )) is compiled with its inner parens when they do not
+  // close at the end, so $((a)+(b)) works too.
+  if (left >= 2 && text[0] == '(' && text[1] == '(')
+  {
+    uint32_t close = yash_matchParen(text, left, 0);
+    if (close == UINT32_MAX)
+    {
+      return NODE_NONE;
+    }
+    *end = index + 1 + close;
+    int isInner = yash_matchParen(text, left, 1) == close - 1;
+    uint32_t expression = yash_compileArithmetic(parser, text + 1 + isInner, close - 1 - 2 * isInner);
+    return yash_addNode(parser->ast, NODE_ARITH, expression, 0, 0);
+  }
+
+  uint32_t nameStart = text[0] == '{' ? 1 : 0;
+  uint32_t nameLength = yash_nameLength(text + nameStart, left - nameStart);
+  if (nameLength == 0 || (nameStart == 1 && (nameLength + 1 >= left || text[nameLength + 1] != '}')))
+  {
+    return NODE_NONE;
+  }
+  *end = index + nameStart * 2 + nameLength;
+  uint32_t name = yash_addString(parser->ast, text + nameStart, nameLength);
+  return yash_addNode(parser->ast, NODE_VARIABLE, name, 0, 0);
+}
+
+// this is the function used to compile a word token into a node. The quotes and
+// backslashes are removed and the expansions are made separate parts so the word does
+// not have to be scanned again when it is executed. A word without expansions is one literal.
+uint32_t yash_compileWord(yash_parser *parser, const yash_token *token)
+{
+  const char *raw = parser->source + token->start;
+  char *literal = malloc(token->length + 1);
+  uint32_t literalLength = 0;
+  uint32_t *parts = NULL;
+  uint32_t partCount = 0;
+  uint32_t partCapacity = 0;
+  char quote = '\0';
+
+  for (uint32_t index = 0; index < token->length; index++)
+  {
+    char character = raw[index];
+
+    if (quote == '\0' && (character == '\'' || character == '"'))
+    {
+      quote = character;
+      continue;
+    }
+    if (quote != '\0' && character == quote)
+    {
+      quote = '\0';
+      continue;
+    }
+
+    // in double quotes the backslash only escapes the characters which are special there.
+    if (quote != '\'' && character == '\\' && index + 1 < token->length)
+    {
+      char next = raw[index + 1];
+      if (quote == '"' && strchr("\"\\$", next) == NULL)
+      {
+        literal[literalLength++] = character;
+      }
+      else
+      {
+        literal[literalLength++] = next;
+        index++;
       }
-      // if pipe is encountered then I am using pipe() system call to connect the
-      // the input and output of different commands.
-      else if (strcmp(userPromptList[iterator], "|") == 0)
+      continue;
+    }
+
+    // $?, $NAME, ${NAME} and $(( )) are made separate parts.
+    uint32_t part = NODE_NONE;
+    uint32_t partEnd = index;
+    if (quote != '\'' && character == '$' && index + 1 < token->length)
+    {
+      part = yash_compileExpansion(parser, raw, token->length, index, &partEnd);
+    }
+    if (part != NODE_NONE)
+    {
+      if (literalLength > 0)
       {
-        // saving the character.
-        lastSpecialCharacter = "|";
+        uint32_t offset = yash_addString(parser->ast, literal, literalLength);
+        yash_pushIndex(&parts, &partCount, &partCapacity, yash_addNode(parser->ast, NODE_LITERAL, offset, 0, 0));
+        literalLength = 0;
+      }
+      yash_pushIndex(&parts, &partCount, &partCapacity, part);
+      index = partEnd;
+      continue;
+    }
+
+    literal[literalLength++] = character;
+  }
+
+  if (literalLength > 0 || partCount == 0)
+  {
+    uint32_t offset = yash_addString(parser->ast, literal, literalLength);
+    yash_pushIndex(&parts, &partCount, &partCapacity, yash_addNode(parser->ast, NODE_LITERAL, offset, 0, 0));
+  }
+  free(literal);
+
+  uint32_t word = parts[0];
+  if (partCount > 1)
+  {
+    uint32_t first = yash_addList(parser->ast, parts, partCount);
+    word = yash_addNode(parser->ast, NODE_WORD, first, partCount, 0);
+  }
+  free(parts);
+  return word;
+}
+
+// this is the function used to print the syntax error of an arithmetic expression,
+// only the first error is printed.
+void yash_arithError(yash_arithParser *arith)
+{
+  if (!arith->parser->hasError)
+  {
+    arith->parser->hasError = 1;
+    fprintf(stderr, "Error: Syntax error in arithmetic expression '%.*s' on line %u \n",
+            (int)arith->length, arith->text, yash_peekToken(arith->parser)->line);
+  }
+}
+
+// this is the function used to skip the spaces and new lines in an arithmetic expression.
+void yash_skipArithSpaces(yash_arithParser *arith)
+{
+  while (arith->position < arith->length && isspace((unsigned char)arith->text[arith->position]))
+  {
+    arith->position++;
+  }
+}
+
+// this is the function used to check if the text at the current position starts with the
+// given operator, it moves past the operator if it does.
+int yash_matchArith(yash_arithParser *arith, const char *operator)
+{
+  yash_skipArithSpaces(arith);
+  size_t length = strlen(operator);
+  if (arith->length - arith->position >= length &&
+      strncmp(arith->text + arith->position, operator, length) == 0)
+  {
+    arith->position += length;
+    return 1;
+  }
+  return 0;
+}
+
+// this is the function used to find the binary operator at the current position, it returns
+// its index in yash_arithOperators or -1. An operator followed by = is an assignment like +=
+// and is not taken, except for the comparisons.
+int yash_findArithOperator(yash_arithParser *arith)
+{
+  yash_skipArithSpaces(arith);
+  const char *text = arith->text + arith->position;
+  uint32_t left = arith->length - arith->position;
+  for (int operator = 0; operator < ARITH_ASSIGN; operator++)
+  {
+    size_t length = strlen(yash_arithOperators[operator]);
+    if (left >= length && strncmp(text, yash_arithOperators[operator], length) == 0)
+    {
+      int isAssignment = length == 1 && left > 1 && text[1] == '=' && operator != ARITH_LESS && operator != ARITH_GREAT;
+      return isAssignment ? -1 : operator;
+    }
+  }
+  return -1;
+}
+
+// this is the function used to read a variable name at the current position,
+// it stores the offset of the name in the strings and returns 0, or -1 if there is no name.
+int yash_parseArithName(yash_arithParser *arith, uint32_t *name)
+{
+  yash_skipArithSpaces(arith);
+  uint32_t length = yash_nameLength(arith->text + arith->position, arith->length - arith->position);
+  if (length == 0)
+  {
+    return -1;
+  }
+  *name = yash_addString(arith->parser->ast, arith->text + arith->position, length);
+  arith->position += length;
+  return 0;
+}
+
+uint32_t yash_parseArithAssign(yash_arithParser *arith);
+
+// this is the function used to parse a number, a variable, $?, $NAME, ${NAME} or an
+// expression in parens. A variable can be followed by ++ or --.
+uint32_t yash_parseArithPrimary(yash_arithParser *arith)
+{
+  yash_skipArithSpaces(arith);
+  const char *text = arith->text + arith->position;
+  uint32_t left = arith->length - arith->position;
+
+  if (left > 0 && isdigit((unsigned char)text[0]))
+  {
+    // the number is copied as the expression is not NULL terminated.
+    char number[32];
+    uint32_t length = 0;
+    while (length < left && length < sizeof(number) - 1 && isalnum((unsigned char)text[length]))
+    {
+      number[length] = text[length];
+      length++;
+    }
+    number[length] = '\0';
+
+    char *end;
+    errno = 0;
+    uint64_t value = strtoull(number, &end, 0);
+    if (*end != '\0' || errno != 0)
+    {
+      yash_arithError(arith);
+      return NODE_NONE;
+    }
+    arith->position += length;
+    return yash_addNode(arith->parser->ast, NODE_ARITH_NUMBER, (uint32_t)value, (uint32_t)(value >> 32), 0);
+  }
+
+  if (yash_matchArith(arith, "("))
+  {
+    uint32_t expression = yash_parseArithAssign(arith);
+    if (!yash_matchArith(arith, ")"))
+    {
+      yash_arithError(arith);
+      return NODE_NONE;
+    }
+    return expression;
+  }
+
+  if (yash_matchArith(arith, "$?"))
+  {
+    return yash_addNode(arith->parser->ast, NODE_STATUS, 0, 0, 0);
+  }
+
+  // the $ is optional for variables, ${NAME} needs its closing brace.
+  int hasBrace = yash_matchArith(arith, "${");
+  if (!hasBrace)
+  {
+    yash_matchArith(arith, "$");
+  }
+  uint32_t name;
+  if (yash_parseArithName(arith, &name) == -1 || (hasBrace && !yash_matchArith(arith, "}")))
+  {
+    yash_arithError(arith);
+    return NODE_NONE;
+  }
+
+  if (yash_matchArith(arith, "++"))
+  {
+    return yash_addNode(arith->parser->ast, NODE_ARITH_INCREMENT, name, ARITH_POST_INCREMENT, 0);
+  }
+  if (yash_matchArith(arith, "--"))
+  {
+    return yash_addNode(arith->parser->ast, NODE_ARITH_INCREMENT, name, ARITH_POST_DECREMENT, 0);
+  }
+  return yash_addNode(arith->parser->ast, NODE_VARIABLE, name, 0, 0);
+}
+
+// this is the function used to parse the unary operators - + ! ~ and ++ or -- before a variable.
+uint32_t yash_parseArithUnary(yash_arithParser *arith)
+{
+  int isIncrement = yash_matchArith(arith, "++");
+  if (isIncrement || yash_matchArith(arith, "--"))
+  {
+    uint32_t name;
+    if (yash_parseArithName(arith, &name) == -1)
+    {
+      yash_arithError(arith);
+      return NODE_NONE;
+    }
+    return yash_addNode(arith->parser->ast, NODE_ARITH_INCREMENT, name,
+                        isIncrement ? ARITH_PRE_INCREMENT : ARITH_PRE_DECREMENT, 0);
+  }
+
+  yash_skipArithSpaces(arith);
+  if (arith->position < arith->length && strchr("-+!~", arith->text[arith->position]) != NULL)
+  {
+    char operator = arith->text[arith->position];
+    arith->position++;
+    uint32_t operand = yash_parseArithUnary(arith);
+    if (arith->parser->hasError)
+    {
+      return NODE_NONE;
+    }
+    return yash_addNode(arith->parser->ast, NODE_ARITH_UNARY, operand, operator, 0);
+  }
+  return yash_parseArithPrimary(arith);
+}
+
+// this is the function used to parse the binary operators with precedence climbing,
+// only the operators with at least the given precedence are taken at this level.
+uint32_t yash_parseArithBinary(yash_arithParser *arith, int minimumPrecedence)
+{
+  uint32_t left = yash_parseArithUnary(arith);
+  while (!arith->parser->hasError)
+  {
+    int operator = yash_findArithOperator(arith);
+    if (operator == -1 || yash_arithPrecedence[operator] < minimumPrecedence)
+    {
+      break;
+    }
+    arith->position += strlen(yash_arithOperators[operator]);
+
+    uint32_t right = yash_parseArithBinary(arith, yash_arithPrecedence[operator] + 1);
+    if (arith->parser->hasError)
+    {
+      return NODE_NONE;
+    }
+    left = yash_addNode(arith->parser->ast, NODE_ARITH_BINARY, left, right, operator);
+  }
+  return arith->parser->hasError ? NODE_NONE : left;
+}
+
+// this is the function used to parse the condition ? value : value operator.
+uint32_t yash_parseArithCondition(yash_arithParser *arith)
+{
+  uint32_t condition = yash_parseArithBinary(arith, 1);
+  if (arith->parser->hasError || !yash_matchArith(arith, "?"))
+  {
+    return condition;
+  }
+
+  uint32_t whenTrue = yash_parseArithAssign(arith);
+  if (arith->parser->hasError || !yash_matchArith(arith, ":"))
+  {
+    yash_arithError(arith);
+    return NODE_NONE;
+  }
+  uint32_t whenFalse = yash_parseArithCondition(arith);
+  if (arith->parser->hasError)
+  {
+    return NODE_NONE;
+  }
+  return yash_addNode(arith->parser->ast, NODE_ARITH_CONDITION, condition, whenTrue, whenFalse);
+}
+
+// this is the function used to parse an assignment NAME = value or NAME op= value,
+// if the expression is not an assignment it is parsed as a condition.
+uint32_t yash_parseArithAssign(yash_arithParser *arith)
+{
+  uint32_t start = arith->position;
+  uint32_t stringBytes = arith->parser->ast->stringBytes;
+  uint32_t name;
+  if (yash_parseArithName(arith, &name) == 0)
+  {
+    yash_skipArithSpaces(arith);
+    const char *text = arith->text + arith->position;
+    uint32_t left = arith->length - arith->position;
+    int operator = -1;
+    if (left >= 1 && text[0] == '=' && (left == 1 || text[1] != '='))
+    {
+      operator = ARITH_ASSIGN;
+      arith->position++;
+    }
+    else if (left >= 2 && text[1] == '=' && strchr("+-*/%", text[0]) != NULL)
+    {
+      const char compound[2] = {text[0], '\0'};
+      for (operator = ARITH_ADD; strcmp(yash_arithOperators[operator], compound) != 0; operator++)
+      {
+      }
+      arith->position += 2;
+    }
+
+    if (operator != -1)
+    {
+      uint32_t value = yash_parseArithAssign(arith);
+      if (arith->parser->hasError)
+      {
+        return NODE_NONE;
+      }
+      return yash_addNode(arith->parser->ast, NODE_ARITH_ASSIGN, name, value, operator);
+    }
+
+    // it was not an assignment so the name is read again by the condition.
+    arith->position = start;
+    arith->parser->ast->stringBytes = stringBytes;
+  }
+  return yash_parseArithCondition(arith);
+}
+
+// this is the function used to compile an arithmetic expression into nodes,
+// the whole text must be one expression.
+uint32_t yash_compileArithmetic(yash_parser *parser, const char *text, uint32_t length)
+{
+  yash_arithParser arith = {parser, text, length, 0};
+  uint32_t expression = yash_parseArithAssign(&arith);
+  yash_skipArithSpaces(&arith);
+  if (!parser->hasError && arith.position != length)
+  {
+    yash_arithError(&arith);
+  }
+  return parser->hasError ? NODE_NONE : expression;
+}
+
+// this is the function used to check if a redirection starts at the current token,
+// either an operator or the fd number before it.
+int yash_isRedirectStart(yash_parser *parser)
+{
+  int type = yash_peekToken(parser)->type;
+  return type == TOKEN_IO_NUMBER || type == TOKEN_GREAT || type == TOKEN_DOUBLE_GREAT ||
+         type == TOKEN_LESS || type == TOKEN_GREAT_AND || type == TOKEN_LESS_AND ||
+         type == TOKEN_AND_GREAT || type == TOKEN_AND_DOUBLE_GREAT;
+}
+
+// this is the function used to parse a redirection: [N]>word, [N]>>word, [N]<word,
+// [N]>&word, [N]<&word, &>word and &>>word. The type and the fd are stored together
+// in redirect (type | fd << 8) and the target word in target. It returns -1 on error.
+int yash_parseRedirection(yash_parser *parser, uint32_t *redirect, uint32_t *target)
+{
+  long fd = -1;
+  const yash_token *token = yash_peekToken(parser);
+  if (token->type == TOKEN_IO_NUMBER)
+  {
+    fd = token->length <= 4 ? strtol(parser->source + token->start, NULL, 10) : REDIRECT_MAX_FD + 1;
+    if (fd > REDIRECT_MAX_FD)
+    {
+      yash_syntaxError(parser);
+      return -1;
+    }
+    parser->position++;
+    token = yash_peekToken(parser);
+  }
+
+  int type;
+  int defaultFD = STDOUT_FILENO;
+  if (token->type == TOKEN_GREAT)
+  {
+    type = REDIRECT_OUTPUT;
+  }
+  else if (token->type == TOKEN_DOUBLE_GREAT)
+  {
+    type = REDIRECT_APPEND;
+  }
+  else if (token->type == TOKEN_LESS)
+  {
+    type = REDIRECT_INPUT;
+    defaultFD = STDIN_FILENO;
+  }
+  else if (token->type == TOKEN_GREAT_AND)
+  {
+    type = REDIRECT_DUPLICATE;
+  }
+  else if (token->type == TOKEN_LESS_AND)
+  {
+    type = REDIRECT_DUPLICATE;
+    defaultFD = STDIN_FILENO;
+  }
+  else if (fd == -1 && token->type == TOKEN_AND_GREAT)
+  {
+    type = REDIRECT_OUTPUT_ALL;
+  }
+  else if (fd == -1 && token->type == TOKEN_AND_DOUBLE_GREAT)
+  {
+    type = REDIRECT_APPEND_ALL;
+  }
+  else
+  {
+    yash_syntaxError(parser);
+    return -1;
+  }
+  parser->position++;
+
+  if (yash_peekToken(parser)->type != TOKEN_WORD)
+  {
+    yash_syntaxError(parser);
+    return -1;
+  }
+  *redirect = type | (uint32_t)(fd == -1 ? defaultFD : fd) << 8;
+  *target = yash_compileWord(parser, yash_peekToken(parser));
+  parser->position++;
+  return 0;
+}
+
+// this is the function used to parse a redirection and wrap the node with it.
+uint32_t yash_parseRedirect(yash_parser *parser, uint32_t node)
+{
+  uint32_t redirect;
+  uint32_t target;
+  if (yash_parseRedirection(parser, &redirect, &target) == -1)
+  {
+    return NODE_NONE;
+  }
+  return yash_addNode(parser->ast, NODE_REDIRECT, node, redirect, target);
+}
+
+// this is the function used to get the length of the name if the word token is an
+// assignment NAME=value, it returns 0 if it is not one.
+uint32_t yash_assignmentLength(yash_parser *parser, const yash_token *token)
+{
+  const char *text = parser->source + token->start;
+  uint32_t nameLength = yash_nameLength(text, token->length);
+  return nameLength > 0 && nameLength < token->length && text[nameLength] == '=' ? nameLength : 0;
+}
+
+// this is the function used to parse a simple command, the assignments, words and
+// redirections until an operator. If the words are seperated by # the command is made a cat
+// of all the files as the # concatenation operator works the same as cat.
+// the assignments before the first word are kept at the start of the words of the command.
+uint32_t yash_parseSimpleCommand(yash_parser *parser)
+{
+  uint32_t *words = NULL;
+  uint32_t wordCount = 0;
+  uint32_t wordCapacity = 0;
+  uint32_t assignmentCount = 0;
+  uint32_t *redirects = NULL;
+  uint32_t redirectCount = 0;
+  uint32_t redirectCapacity = 0;
+  int hasConcatenation = 0;
+
+  while (!parser->hasError)
+  {
+    const yash_token *token = yash_peekToken(parser);
+    uint32_t nameLength = token->type == TOKEN_WORD && wordCount == assignmentCount && !hasConcatenation
+                              ? yash_assignmentLength(parser, token)
+                              : 0;
+    if (nameLength > 0)
+    {
+      yash_token value = {TOKEN_WORD, token->start + nameLength + 1, token->length - nameLength - 1, token->line};
+      uint32_t name = yash_addString(parser->ast, parser->source + token->start, nameLength);
+      uint32_t assignment = yash_addNode(parser->ast, NODE_ASSIGN, name, yash_compileWord(parser, &value), 0);
+      yash_pushIndex(&words, &wordCount, &wordCapacity, assignment);
+      assignmentCount++;
+      parser->position++;
+    }
+    else if (token->type == TOKEN_WORD)
+    {
+      if (yash_isWordToken(parser, "#"))
+      {
+        hasConcatenation = 1;
+      }
+      else
+      {
+        yash_pushIndex(&words, &wordCount, &wordCapacity, yash_compileWord(parser, token));
+      }
+      parser->position++;
+    }
+    else if (yash_isRedirectStart(parser))
+    {
+      // the redirections are stored as the type and the target word
+      // and they wrap the command once all its words are known.
+      uint32_t redirect;
+      uint32_t target;
+      if (yash_parseRedirection(parser, &redirect, &target) == -1)
+      {
+        break;
+      }
+      yash_pushIndex(&redirects, &redirectCount, &redirectCapacity, redirect);
+      yash_pushIndex(&redirects, &redirectCount, &redirectCapacity, target);
+    }
+    else
+    {
+      break;
+    }
+  }
+
+  uint32_t node = NODE_NONE;
+  if (!parser->hasError && wordCount == 0)
+  {
+    yash_syntaxError(parser);
+  }
+  if (!parser->hasError)
+  {
+    if (hasConcatenation)
+    {
+      uint32_t cat = yash_addNode(parser->ast, NODE_LITERAL, yash_addString(parser->ast, "cat", 3), 0, 0);
+      yash_pushIndex(&words, &wordCount, &wordCapacity, cat);
+      memmove(words + assignmentCount + 1, words + assignmentCount,
+              sizeof(uint32_t) * (wordCount - assignmentCount - 1));
+      words[assignmentCount] = cat;
+    }
+
+    uint32_t first = yash_addList(parser->ast, words, wordCount);
+    node = yash_addNode(parser->ast, NODE_COMMAND, first, wordCount, assignmentCount);
+    for (uint32_t redirect = 0; redirect < redirectCount; redirect += 2)
+    {
+      node = yash_addNode(parser->ast, NODE_REDIRECT, node, redirects[redirect], redirects[redirect + 1]);
+    }
+  }
+
+  free(words);
+  free(redirects);
+  return node;
+}
+
+uint32_t yash_parseList(yash_parser *parser);
+
+// this is the function used to parse a list which must be followed by the given reserved
+// word, the reserved word is skipped. It returns NODE_NONE on error.
+uint32_t yash_parseListUntil(yash_parser *parser, const char *reservedWord)
+{
+  uint32_t list = yash_parseList(parser);
+  if (list == NODE_NONE || !yash_isWordToken(parser, reservedWord))
+  {
+    yash_syntaxError(parser);
+    return NODE_NONE;
+  }
+  parser->position++;
+  return list;
+}
+
+// this is the function used to parse if list; then list; [elif list; then list;] [else list;] fi
+// after the if or elif, an elif is parsed as an if in the else branch.
+uint32_t yash_parseIf(yash_parser *parser)
+{
+  uint32_t condition = yash_parseListUntil(parser, "then");
+  uint32_t body = parser->hasError ? NODE_NONE : yash_parseList(parser);
+  if (parser->hasError || body == NODE_NONE)
+  {
+    yash_syntaxError(parser);
+    return NODE_NONE;
+  }
+
+  uint32_t elseBody = NODE_NONE;
+  if (yash_isWordToken(parser, "elif"))
+  {
+    parser->position++;
+    elseBody = yash_parseIf(parser);
+    return parser->hasError ? NODE_NONE : yash_addNode(parser->ast, NODE_IF, condition, body, elseBody);
+  }
+  if (yash_isWordToken(parser, "else"))
+  {
+    parser->position++;
+    elseBody = yash_parseList(parser);
+    if (elseBody == NODE_NONE)
+    {
+      yash_syntaxError(parser);
+      return NODE_NONE;
+    }
+  }
+  if (!yash_isWordToken(parser, "fi"))
+  {
+    yash_syntaxError(parser);
+    return NODE_NONE;
+  }
+  parser->position++;
+  return yash_addNode(parser->ast, NODE_IF, condition, body, elseBody);
+}
+
+// this is the function used to parse the do list done of the loops.
+uint32_t yash_parseLoopBody(yash_parser *parser)
+{
+  yash_skipNewLines(parser);
+  if (!yash_isWordToken(parser, "do"))
+  {
+    yash_syntaxError(parser);
+    return NODE_NONE;
+  }
+  parser->position++;
+  return yash_parseListUntil(parser, "done");
+}
+
+// this is the function used to parse for NAME [in words]; do list done after the for,
+// without in the loop is made over no words.
+uint32_t yash_parseFor(yash_parser *parser)
+{
+  const yash_token *token = yash_peekToken(parser);
+  if (token->type != TOKEN_WORD ||
+      yash_nameLength(parser->source + token->start, token->length) != token->length)
+  {
+    yash_syntaxError(parser);
+    return NODE_NONE;
+  }
+  uint32_t name = yash_addString(parser->ast, parser->source + token->start, token->length);
+  parser->position++;
+
+  uint32_t *words = NULL;
+  uint32_t wordCount = 0;
+  uint32_t wordCapacity = 0;
+  yash_skipNewLines(parser);
+  if (yash_isWordToken(parser, "in"))
+  {
+    parser->position++;
+    while (yash_peekToken(parser)->type == TOKEN_WORD)
+    {
+      yash_pushIndex(&words, &wordCount, &wordCapacity, yash_compileWord(parser, yash_peekToken(parser)));
+      parser->position++;
+    }
+    if (yash_peekToken(parser)->type != TOKEN_SEMICOLON && yash_peekToken(parser)->type != TOKEN_NEWLINE)
+    {
+      yash_syntaxError(parser);
+      free(words);
+      return NODE_NONE;
+    }
+    parser->position++;
+  }
+  else if (yash_peekToken(parser)->type == TOKEN_SEMICOLON)
+  {
+    parser->position++;
+  }
+
+  uint32_t first = yash_addList(parser->ast, words, wordCount);
+  free(words);
+  uint32_t wordList = yash_addNode(parser->ast, NODE_WORD_LIST, first, wordCount, 0);
+  uint32_t body = yash_parseLoopBody(parser);
+  return parser->hasError ? NODE_NONE : yash_addNode(parser->ast, NODE_FOR, name, body, wordList);
+}
+
+// this is the function used to parse a command, a subshell ( list ), a group { list; },
+// an if, a while or until loop, a for loop or (( expression )) with its redirections
+// or a simple command.
+uint32_t yash_parseCommand(yash_parser *parser)
+{
+  uint32_t node;
+  const yash_token *token = yash_peekToken(parser);
+  if (token->type == TOKEN_ARITH)
+  {
+    uint32_t expression = yash_compileArithmetic(parser, parser->source + token->start, token->length);
+    if (parser->hasError)
+    {
+      return NODE_NONE;
+    }
+    parser->position++;
+    node = yash_addNode(parser->ast, NODE_ARITH_COMMAND, expression, 0, 0);
+  }
+  else if (yash_isWordToken(parser, "if"))
+  {
+    parser->position++;
+    node = yash_parseIf(parser);
+  }
+  else if (yash_isWordToken(parser, "while") || yash_isWordToken(parser, "until"))
+  {
+    uint32_t isUntil = yash_isWordToken(parser, "until");
+    parser->position++;
+    uint32_t condition = yash_parseList(parser);
+    if (condition == NODE_NONE)
+    {
+      yash_syntaxError(parser);
+      return NODE_NONE;
+    }
+    uint32_t body = yash_parseLoopBody(parser);
+    node = parser->hasError ? NODE_NONE : yash_addNode(parser->ast, NODE_WHILE, condition, body, isUntil);
+  }
+  else if (yash_isWordToken(parser, "for"))
+  {
+    parser->position++;
+    node = yash_parseFor(parser);
+  }
+  else if (token->type == TOKEN_OPEN_PAREN)
+  {
+    parser->position++;
+    uint32_t body = yash_parseList(parser);
+    if (body == NODE_NONE || yash_peekToken(parser)->type != TOKEN_CLOSE_PAREN)
+    {
+      yash_syntaxError(parser);
+      return NODE_NONE;
+    }
+    parser->position++;
+    node = yash_addNode(parser->ast, NODE_SUBSHELL, body, 0, 0);
+  }
+  else if (yash_isWordToken(parser, "{"))
+  {
+    parser->position++;
+    uint32_t body = yash_parseList(parser);
+    if (body == NODE_NONE || !yash_isWordToken(parser, "}"))
+    {
+      yash_syntaxError(parser);
+      return NODE_NONE;
+    }
+    parser->position++;
+    node = yash_addNode(parser->ast, NODE_GROUP, body, 0, 0);
+  }
+  else
+  {
+    return yash_parseSimpleCommand(parser);
+  }
+
+  while (!parser->hasError && yash_isRedirectStart(parser))
+  {
+    node = yash_parseRedirect(parser, node);
+  }
+  return node;
+}
+
+// this is the function used to parse a pipeline, the commands seperated by |.
+// a pipeline which starts with profile is always made a pipeline node, even with one stage.
+uint32_t yash_parsePipeline(yash_parser *parser)
+{
+  uint32_t *stages = NULL;
+  uint32_t stageCount = 0;
+  uint32_t stageCapacity = 0;
+  uint32_t isProfiled = yash_isWordToken(parser, "profile");
+  parser->position += isProfiled;
+
+  yash_pushIndex(&stages, &stageCount, &stageCapacity, yash_parseCommand(parser));
+  while (!parser->hasError && yash_peekToken(parser)->type == TOKEN_PIPE)
+  {
+    parser->position++;
+    yash_skipNewLines(parser);
+    yash_pushIndex(&stages, &stageCount, &stageCapacity, yash_parseCommand(parser));
+  }
+
+  uint32_t node = stages[0];
+  if (!parser->hasError && (stageCount > 1 || isProfiled))
+  {
+    uint32_t first = yash_addList(parser->ast, stages, stageCount);
+    node = yash_addNode(parser->ast, NODE_PIPELINE, first, stageCount, isProfiled);
+  }
+  free(stages);
+  return parser->hasError ? NODE_NONE : node;
+}
+
+uint32_t yash_parseAndOr(yash_parser *parser);
+
+// this is the function used to parse the watch and onchange builtins, they take the
+// rest of the && and || list as the command to run again, so for
+// onchange src -- make && ./test the whole make && ./test is run on each change.
+// the words of the builtin (without --) and the text of the command are stored in the list.
+uint32_t yash_parseWatch(yash_parser *parser)
+{
+  uint32_t *words = NULL;
+  uint32_t wordCount = 0;
+  uint32_t wordCapacity = 0;
+  int isOnChange = yash_isWordToken(parser, "onchange");
+
+  yash_pushIndex(&words, &wordCount, &wordCapacity, yash_compileWord(parser, yash_peekToken(parser)));
+  parser->position++;
+
+  if (isOnChange)
+  {
+    while (yash_peekToken(parser)->type == TOKEN_WORD && !yash_isWordToken(parser, "--"))
+    {
+      yash_pushIndex(&words, &wordCount, &wordCapacity, yash_compileWord(parser, yash_peekToken(parser)));
+      parser->position++;
+    }
+    if (!yash_isWordToken(parser, "--"))
+    {
+      yash_syntaxError(parser);
+      free(words);
+      return NODE_NONE;
+    }
+    parser->position++;
+  }
+  else if (yash_isWordToken(parser, "-n"))
+  {
+    for (int option = 0; option < 2 && yash_peekToken(parser)->type == TOKEN_WORD; option++)
+    {
+      yash_pushIndex(&words, &wordCount, &wordCapacity, yash_compileWord(parser, yash_peekToken(parser)));
+      parser->position++;
+    }
+  }
+
+  uint32_t textStart = yash_peekToken(parser)->start;
+  uint32_t child = yash_parseAndOr(parser);
+  if (parser->hasError)
+  {
+    free(words);
+    return NODE_NONE;
+  }
+
+  const yash_token *last = &parser->tokens[parser->position - 1];
+  uint32_t text = yash_addString(parser->ast, parser->source + textStart, last->start + last->length - textStart);
+  yash_pushIndex(&words, &wordCount, &wordCapacity, yash_addNode(parser->ast, NODE_LITERAL, text, 0, 0));
+
+  uint32_t first = yash_addList(parser->ast, words, wordCount);
+  free(words);
+  return yash_addNode(parser->ast, NODE_WATCH, child, first, wordCount);
+}
+
+// this is the function used to parse the pipelines seperated by && and ||,
+// they have the same precedence and are grouped from left to right.
+uint32_t yash_parseAndOr(yash_parser *parser)
+{
+  if (yash_isWordToken(parser, "watch") || yash_isWordToken(parser, "onchange"))
+  {
+    return yash_parseWatch(parser);
+  }
+
+  uint32_t node = yash_parsePipeline(parser);
+  while (!parser->hasError &&
+         (yash_peekToken(parser)->type == TOKEN_AND || yash_peekToken(parser)->type == TOKEN_OR))
+  {
+    uint32_t type = yash_peekToken(parser)->type == TOKEN_AND ? NODE_AND : NODE_OR;
+    parser->position++;
+    yash_skipNewLines(parser);
+    uint32_t right = yash_parsePipeline(parser);
+    if (parser->hasError)
+    {
+      return NODE_NONE;
+    }
+    node = yash_addNode(parser->ast, type, node, right, 0);
+  }
+  return node;
+}
+
+// this is the function used to check if the list ends at the current token,
+// at the end of input, at ) of a subshell, at } of a group or at a reserved word
+// which ends a part of an if or a loop.
+int yash_isListEnd(yash_parser *parser)
+{
+  static const char *reservedWords[] = {"}", "then", "elif", "else", "fi", "do", "done"};
+  int type = yash_peekToken(parser)->type;
+  if (type == TOKEN_END || type == TOKEN_CLOSE_PAREN)
+  {
+    return 1;
+  }
+  for (size_t word = 0; word < sizeof(reservedWords) / sizeof(reservedWords[0]); word++)
+  {
+    if (yash_isWordToken(parser, reservedWords[word]))
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// this is the function used to parse a list of commands seperated by ;, & or new lines.
+// a command followed by & runs in the background. It returns NODE_NONE if the list is empty.
+uint32_t yash_parseList(yash_parser *parser)
+{
+  uint32_t *items = NULL;
+  uint32_t itemCount = 0;
+  uint32_t itemCapacity = 0;
+
+  yash_skipNewLines(parser);
+  while (!parser->hasError && !yash_isListEnd(parser))
+  {
+    uint32_t node = yash_parseAndOr(parser);
+    if (parser->hasError)
+    {
+      break;
+    }
+
+    int type = yash_peekToken(parser)->type;
+    if (type == TOKEN_BACKGROUND)
+    {
+      node = yash_addNode(parser->ast, NODE_BACKGROUND, node, 0, 0);
+      parser->position++;
+    }
+    else if (type == TOKEN_SEMICOLON || type == TOKEN_NEWLINE)
+    {
+      parser->position++;
+    }
+    else if (!yash_isListEnd(parser))
+    {
+      yash_syntaxError(parser);
+      break;
+    }
+
+    yash_pushIndex(&items, &itemCount, &itemCapacity, node);
+    yash_skipNewLines(parser);
+  }
+
+  uint32_t node = NODE_NONE;
+  if (!parser->hasError && itemCount == 1)
+  {
+    node = items[0];
+  }
+  else if (!parser->hasError && itemCount > 1)
+  {
+    uint32_t first = yash_addList(parser->ast, items, itemCount);
+    node = yash_addNode(parser->ast, NODE_LIST, first, itemCount, 0);
+  }
+  free(items);
+  return node;
+}
+
+// this is the function used to parse a prompt or a whole script into the tree.
+// it returns -1 if there is a syntax error, an empty source gives root NODE_NONE.
+// if isPrompt is set and the source ends in the middle of a command it returns -2
+// without printing an error, so the prompt can read the next line.
+int yash_parse(const char *source, uint32_t sourceSize, yash_ast *ast, int isPrompt)
+{
+  memset(ast, 0, sizeof(*ast));
+  ast->root = NODE_NONE;
+
+  yash_parser parser;
+  memset(&parser, 0, sizeof(parser));
+  parser.source = source;
+  parser.ast = ast;
+  parser.isPrompt = isPrompt;
+  int lexStatus = yash_lex(source, sourceSize, &parser.tokens, &parser.tokenCount, isPrompt);
+  if (lexStatus != 0)
+  {
+    return lexStatus;
+  }
+
+  uint32_t root = yash_parseList(&parser);
+  if (!parser.hasError && yash_peekToken(&parser)->type != TOKEN_END)
+  {
+    yash_syntaxError(&parser);
+  }
+  free(parser.tokens);
+
+  if (parser.hasError)
+  {
+    yash_freeAst(ast);
+    return parser.isIncomplete ? -2 : -1;
+  }
+  ast->root = root;
+  return 0;
+}
+
+// this is the function used to check if a node is of the kind a parent expects: a part
+// of a word, a word, a command which the executor can run or an arithmetic expression.
+int yash_isNodeKind(const yash_ast *ast, uint32_t index, int kind)
+{
+  uint32_t type = ast->nodes[index].type;
+  int isPart = type == NODE_LITERAL || type == NODE_STATUS || type == NODE_VARIABLE || type == NODE_ARITH;
+  switch (kind)
+  {
+  case NODE_KIND_PART:
+    return isPart;
+  case NODE_KIND_WORD:
+    return isPart || type == NODE_WORD;
+  case NODE_KIND_ARITH:
+    return type == NODE_ARITH_NUMBER || type == NODE_STATUS || type == NODE_VARIABLE ||
+           (type >= NODE_ARITH_UNARY && type <= NODE_ARITH_INCREMENT);
+  }
+  return type == NODE_COMMAND || (type >= NODE_PIPELINE && type <= NODE_WATCH) ||
+         (type >= NODE_IF && type <= NODE_FOR) || type == NODE_ARITH_COMMAND;
+}
+
+// this is the function used to check if the items of a range of the lists are all of a kind.
+int yash_isRangeKind(const yash_ast *ast, uint32_t first, uint32_t count, int kind)
+{
+  for (uint32_t item = 0; item < count; item++)
+  {
+    if (!yash_isNodeKind(ast, ast->lists[first + item], kind))
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+// this is the function used to check the kinds of the children of a node which are
+// already known to be inside the tree. Without it a changed cache could make the executor
+// use the fields of a node as string offsets or ranges of another type of node.
+int yash_checkNodeKinds(const yash_ast *ast, const yash_node *node)
+{
+  switch (node->type)
+  {
+  case NODE_WORD:
+    return yash_isRangeKind(ast, node->left, node->right, NODE_KIND_PART);
+  case NODE_COMMAND:
+    for (uint32_t item = 0; item < node->extra; item++)
+    {
+      if (ast->nodes[ast->lists[node->left + item]].type != NODE_ASSIGN)
+      {
+        return 0;
+      }
+    }
+    return yash_isRangeKind(ast, node->left + node->extra, node->right - node->extra, NODE_KIND_WORD);
+  case NODE_WORD_LIST:
+    return yash_isRangeKind(ast, node->left, node->right, NODE_KIND_WORD);
+  case NODE_PIPELINE:
+  case NODE_LIST:
+    return yash_isRangeKind(ast, node->left, node->right, NODE_KIND_COMMAND);
+  case NODE_AND:
+  case NODE_OR:
+  case NODE_WHILE:
+    return yash_isNodeKind(ast, node->left, NODE_KIND_COMMAND) && yash_isNodeKind(ast, node->right, NODE_KIND_COMMAND);
+  case NODE_IF:
+    return yash_isNodeKind(ast, node->left, NODE_KIND_COMMAND) && yash_isNodeKind(ast, node->right, NODE_KIND_COMMAND) &&
+           (node->extra == NODE_NONE || yash_isNodeKind(ast, node->extra, NODE_KIND_COMMAND));
+  case NODE_FOR:
+    return yash_isNodeKind(ast, node->right, NODE_KIND_COMMAND);
+  case NODE_BACKGROUND:
+  case NODE_SUBSHELL:
+  case NODE_GROUP:
+    return yash_isNodeKind(ast, node->left, NODE_KIND_COMMAND);
+  case NODE_REDIRECT:
+    return yash_isNodeKind(ast, node->left, NODE_KIND_COMMAND) && yash_isNodeKind(ast, node->extra, NODE_KIND_WORD);
+  case NODE_ASSIGN:
+    return yash_isNodeKind(ast, node->right, NODE_KIND_WORD);
+  case NODE_WATCH:
+    // the last word is the text of the command which is used as a string.
+    return yash_isNodeKind(ast, node->left, NODE_KIND_COMMAND) &&
+           yash_isRangeKind(ast, node->right, node->extra, NODE_KIND_WORD) &&
+           ast->nodes[ast->lists[node->right + node->extra - 1]].type == NODE_LITERAL;
+  case NODE_ARITH:
+  case NODE_ARITH_COMMAND:
+  case NODE_ARITH_UNARY:
+    return yash_isNodeKind(ast, node->left, NODE_KIND_ARITH);
+  case NODE_ARITH_BINARY:
+    return yash_isNodeKind(ast, node->left, NODE_KIND_ARITH) && yash_isNodeKind(ast, node->right, NODE_KIND_ARITH);
+  case NODE_ARITH_CONDITION:
+    return yash_isNodeKind(ast, node->left, NODE_KIND_ARITH) && yash_isNodeKind(ast, node->right, NODE_KIND_ARITH) &&
+           yash_isNodeKind(ast, node->extra, NODE_KIND_ARITH);
+  case NODE_ARITH_ASSIGN:
+    return yash_isNodeKind(ast, node->right, NODE_KIND_ARITH);
+  }
+  return 1;
+}
+
+// this is the function used to check the tree loaded from the cache before it is used.
+// every child must come before its parent, so the tree can not have a cycle, and
+// every index and offset must be inside its section and every child must be of the
+// kind its parent expects.
+int yash_checkAst(const yash_ast *ast)
+{
+  if (ast->stringBytes > 0 && ast->strings[ast->stringBytes - 1] != '\0')
+  {
+    return -1;
+  }
+  if (ast->root != NODE_NONE && (ast->root >= ast->nodeCount || !yash_isNodeKind(ast, ast->root, NODE_KIND_COMMAND)))
+  {
+    return -1;
+  }
+
+  for (uint32_t index = 0; index < ast->nodeCount; index++)
+  {
+    const yash_node *node = &ast->nodes[index];
+    int hasRange = 0;
+    int isValid = 1;
+
+    switch (node->type)
+    {
+    case NODE_LITERAL:
+    case NODE_VARIABLE:
+      isValid = node->left < ast->stringBytes;
+      break;
+    case NODE_STATUS:
+    case NODE_ARITH_NUMBER:
+      break;
+    case NODE_COMMAND:
+      isValid = node->extra <= node->right;
+      hasRange = 1;
+      break;
+    case NODE_PIPELINE:
+      isValid = node->extra <= 1;
+      hasRange = 1;
+      break;
+    case NODE_WORD:
+    case NODE_LIST:
+    case NODE_WORD_LIST:
+      hasRange = 1;
+      break;
+    case NODE_AND:
+    case NODE_OR:
+    case NODE_WHILE:
+    case NODE_ARITH_BINARY:
+      isValid = node->left < index && node->right < index &&
+                (node->type != NODE_ARITH_BINARY || node->extra < ARITH_ASSIGN);
+      break;
+    case NODE_IF:
+      isValid = node->left < index && node->right < index && (node->extra == NODE_NONE || node->extra < index);
+      break;
+    case NODE_ARITH_CONDITION:
+      isValid = node->left < index && node->right < index && node->extra < index;
+      break;
+    case NODE_FOR:
+      isValid = node->left < ast->stringBytes && node->right < index && node->extra < index &&
+                ast->nodes[node->extra].type == NODE_WORD_LIST;
+      break;
+    case NODE_ASSIGN:
+    case NODE_ARITH_ASSIGN:
+      isValid = node->left < ast->stringBytes && node->right < index &&
+                (node->type == NODE_ASSIGN || node->extra <= ARITH_ASSIGN);
+      break;
+    case NODE_ARITH_INCREMENT:
+      isValid = node->left < ast->stringBytes && node->right <= ARITH_POST_DECREMENT;
+      break;
+    case NODE_ARITH_UNARY:
+      isValid = node->left < index && node->right != 0 && node->right < 128 &&
+                strchr("-+!~", (int)node->right) != NULL;
+      break;
+    case NODE_BACKGROUND:
+    case NODE_SUBSHELL:
+    case NODE_GROUP:
+    case NODE_ARITH:
+    case NODE_ARITH_COMMAND:
+      isValid = node->left < index;
+      break;
+    case NODE_REDIRECT:
+      isValid = node->left < index && node->extra < index && (node->right & 0xff) >= REDIRECT_OUTPUT &&
+                (node->right & 0xff) <= REDIRECT_APPEND_ALL && (node->right >> 8) <= REDIRECT_MAX_FD;
+      break;
+    case NODE_WATCH:
+      isValid = node->left < index && node->extra > 0 &&
+                (uint64_t)node->right + node->extra <= ast->listCount;
+      for (uint32_t item = 0; isValid && item < node->extra; item++)
+      {
+        isValid = ast->lists[node->right + item] < index;
+      }
+      break;
+    default:
+      isValid = 0;
+    }
+
+    if (hasRange && isValid)
+    {
+      isValid = (node->right > 0 || node->type == NODE_WORD_LIST) &&
+                (uint64_t)node->left + node->right <= ast->listCount;
+      for (uint32_t item = 0; isValid && item < node->right; item++)
+      {
+        isValid = ast->lists[node->left + item] < index;
+      }
+    }
+
+    if (!isValid || !yash_checkNodeKinds(ast, node))
+    {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// this is the function used to get the time in nanoseconds from the monotonic clock.
+int64_t yash_monotonicNanos()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// this is the function used to parse a duration like 10, 1.5s, 250ms, 2m, 1h or 1d
+// in the same way as the timeout command, it returns -1 if the duration is not valid.
+// nan, inf, zero, negative and too long durations are not valid so the conversion to
+// nanoseconds below always fits.
+int yash_parseDuration(const char *text, int64_t *nanos)
+{
+  char *end;
+  errno = 0;
+  double value = strtod(text, &end);
+  if (end == text || errno != 0 || !isfinite(value) || value <= 0)
+  {
+    return -1;
+  }
+
+  double multiplier = 1e9;
+  if (strcmp(end, "ms") == 0)
+  {
+    multiplier = 1e6;
+  }
+  else if (strcmp(end, "m") == 0)
+  {
+    multiplier = 60e9;
+  }
+  else if (strcmp(end, "h") == 0)
+  {
+    multiplier = 3600e9;
+  }
+  else if (strcmp(end, "d") == 0)
+  {
+    multiplier = 86400e9;
+  }
+  else if (strcmp(end, "s") != 0 && *end != '\0')
+  {
+    return -1;
+  }
+
+  double total = value * multiplier;
+  if (!(total >= 1 && total <= (double)INT64_MAX / 2))
+  {
+    return -1;
+  }
+  *nanos = (int64_t)total;
+  return 0;
+}
+
+// this is the function used to parse a list of numbers like 0-7,12,16-23
+// used for the cpus and the numa nodes. each number is passed to the setter
+// with the mask, it returns -1 if the list is not valid.
+int yash_parseNumberList(const char *list, long maxNumber, void (*setter)(long, void *), void *mask)
+{
+  const char *reader = list;
+  if (*reader == '\0')
+  {
+    return -1;
+  }
+
+  while (*reader != '\0')
+  {
+    char *end;
+    long first = strtol(reader, &end, 10);
+    if (end == reader || first < 0)
+    {
+      return -1;
+    }
+    long last = first;
+    reader = end;
+
+    if (*reader == '-')
+    {
+      reader++;
+      last = strtol(reader, &end, 10);
+      if (end == reader || last < first)
+      {
+        return -1;
+      }
+      reader = end;
+    }
+
+    if (last >= maxNumber)
+    {
+      return -1;
+    }
+    for (long number = first; number <= last; number++)
+    {
+      setter(number, mask);
+    }
+
+    if (*reader == ',')
+    {
+      reader++;
+    }
+    else if (*reader != '\0')
+    {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// these are the setters used with yash_parseNumberList for cpu and node masks.
+void yash_setCpu(long cpu, void *mask)
+{
+  CPU_SET(cpu, (cpu_set_t *)mask);
+}
+
+void yash_setNode(long node, void *mask)
+{
+  ((unsigned long *)mask)[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+}
+
+// this is the function used to parse a size like 4G or 512M or unlimited for the rlimits.
+int yash_parseLimitValue(const char *value, rlim_t *limit)
+{
+  if (strcmp(value, "unlimited") == 0 || strcmp(value, "inf") == 0)
+  {
+    *limit = RLIM_INFINITY;
+    return 0;
+  }
+
+  char *end;
+  errno = 0;
+  unsigned long long number = strtoull(value, &end, 10);
+  if (end == value || errno != 0 || value[0] == '-')
+  {
+    return -1;
+  }
+
+  int shift = 0;
+  switch (*end)
+  {
+  case 'k':
+  case 'K':
+    shift = 10;
+    break;
+  case 'm':
+  case 'M':
+    shift = 20;
+    break;
+  case 'g':
+  case 'G':
+    shift = 30;
+    break;
+  case 't':
+  case 'T':
+    shift = 40;
+    break;
+  case '\0':
+    break;
+  default:
+    return -1;
+  }
+  if (shift != 0 && end[1] != '\0')
+  {
+    return -1;
+  }
+  if (number > (RLIM_INFINITY >> shift))
+  {
+    return -1;
+  }
+
+  *limit = (rlim_t)number << shift;
+  return 0;
+}
+
+// this is the function used to parse @rlimit=resource:soft[:hard]
+// when only one value is given it is used for both soft and hard limit.
+int yash_parseLaunchLimit(const char *value, yash_launchSpec *spec)
+{
+  static const struct
+  {
+    const char *name;
+    int resource;
+  } resources[] = {
+      {"as", RLIMIT_AS},
+      {"core", RLIMIT_CORE},
+      {"cpu", RLIMIT_CPU},
+      {"data", RLIMIT_DATA},
+      {"fsize", RLIMIT_FSIZE},
+      {"locks", RLIMIT_LOCKS},
+      {"memlock", RLIMIT_MEMLOCK},
+      {"msgqueue", RLIMIT_MSGQUEUE},
+      {"nice", RLIMIT_NICE},
+      {"nofile", RLIMIT_NOFILE},
+      {"nproc", RLIMIT_NPROC},
+      {"rss", RLIMIT_RSS},
+      {"rtprio", RLIMIT_RTPRIO},
+      {"sigpending", RLIMIT_SIGPENDING},
+      {"stack", RLIMIT_STACK}};
+
+  if (spec->limitCount == MAX_LAUNCH_LIMITS)
+  {
+    return -1;
+  }
+
+  char buffer[128];
+  snprintf(buffer, sizeof(buffer), "%s", value);
+  char *soft = strchr(buffer, ':');
+  if (soft == NULL)
+  {
+    return -1;
+  }
+  *soft = '\0';
+  soft++;
+  char *hard = strchr(soft, ':');
+  if (hard != NULL)
+  {
+    *hard = '\0';
+    hard++;
+  }
+
+  for (unsigned long index = 0; index < sizeof(resources) / sizeof(resources[0]); index++)
+  {
+    if (strcmp(buffer, resources[index].name) == 0)
+    {
+      struct rlimit *limit = &spec->limits[spec->limitCount];
+      if (yash_parseLimitValue(soft, &limit->rlim_cur) == -1 ||
+          yash_parseLimitValue(hard != NULL ? hard : soft, &limit->rlim_max) == -1 ||
+          (limit->rlim_max != RLIM_INFINITY && limit->rlim_cur > limit->rlim_max))
+      {
+        return -1;
+      }
+      spec->limitResources[spec->limitCount] = resources[index].resource;
+      spec->limitCount++;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+// this is the function used to read the cpus of a numa node from sysfs so
+// @node binds the cpus as well as the memory of the job like numactl does.
+int yash_addNodeCpus(long node, cpu_set_t *cpus)
+{
+  char path[128];
+  char cpuList[4096];
+  snprintf(path, sizeof(path), "/sys/devices/system/node/node%ld/cpulist", node);
+
+  int fileDescriptor = open(path, O_RDONLY | O_CLOEXEC);
+  if (fileDescriptor < 0)
+  {
+    return -1;
+  }
+  ssize_t count = read(fileDescriptor, cpuList, sizeof(cpuList) - 1);
+  close(fileDescriptor);
+  if (count <= 0)
+  {
+    return -1;
+  }
+  cpuList[count] = '\0';
+  cpuList[strcspn(cpuList, "\n")] = '\0';
+
+  // a node can exist without any cpus (memory only node).
+  if (cpuList[0] == '\0')
+  {
+    return 0;
+  }
+  return yash_parseNumberList(cpuList, CPU_SETSIZE, yash_setCpu, cpus);
+}
+
+// this is the function used to check the name given to @cgroup=, it must be a relative
+// path like batch/job1 without empty, . or .. components.
+int yash_isCgroupNameValid(const char *name)
+{
+  if (name[0] == '\0' || name[0] == '/')
+  {
+    return 0;
+  }
+
+  const char *component = name;
+  while (1)
+  {
+    size_t length = strcspn(component, "/");
+    if (length == 0 || (length == 1 && component[0] == '.') ||
+        (length == 2 && component[0] == '.' && component[1] == '.'))
+    {
+      return 0;
+    }
+    if (component[length] == '\0')
+    {
+      return 1;
+    }
+    component += length + 1;
+  }
+}
+
+// this is the function used to parse the launch modifiers given before a command
+// like @cpus=0-7 @node=1 @nice=10 @rlimit=as:4G @cgroup=batch/job1 @deadline=30s.
+// everything is parsed in the shell so errors are reported before forking,
+// it returns the number of modifier tokens at the start of the arguments or -1.
+int yash_parseLaunchModifiers(char **cmdArgs, int cmdArgsCount, yash_launchSpec *spec)
+{
+  memset(spec, 0, sizeof(*spec));
+
+  int modifiers = 0;
+  while (modifiers < cmdArgsCount && cmdArgs[modifiers][0] == '@')
+  {
+    char *modifier = cmdArgs[modifiers] + 1;
+    char *value = strchr(modifier, '=');
+    if (value == NULL)
+    {
+      break;
+    }
+    value++;
+
+    int isValid = 0;
+    if (strncmp(modifier, "cpus=", 5) == 0)
+    {
+      CPU_ZERO(&spec->cpus);
+      isValid = yash_parseNumberList(value, CPU_SETSIZE, yash_setCpu, &spec->cpus) == 0;
+      spec->hasCpus = 1;
+    }
+    else if (strncmp(modifier, "node=", 5) == 0)
+    {
+      memset(spec->nodeMask, 0, sizeof(spec->nodeMask));
+      isValid = yash_parseNumberList(value, MAX_NUMA_NODES, yash_setNode, spec->nodeMask) == 0;
+      spec->hasNode = 1;
+    }
+    else if (strncmp(modifier, "nice=", 5) == 0)
+    {
+      char *end;
+      long nice = strtol(value, &end, 10);
+      isValid = end != value && *end == '\0' && nice >= -20 && nice <= 19;
+      spec->hasNice = 1;
+      spec->nice = nice;
+    }
+    else if (strncmp(modifier, "rlimit=", 7) == 0)
+    {
+      isValid = yash_parseLaunchLimit(value, spec) == 0;
+    }
+    else if (strncmp(modifier, "deadline=", 9) == 0)
+    {
+      isValid = yash_parseDuration(value, &spec->deadline) == 0;
+    }
+    else if (strncmp(modifier, "cgroup=", 7) == 0)
+    {
+      // the name is always taken from the root of the cgroup v2 hierarchy so a job
+      // can not be moved to a directory outside of it.
+      int length = snprintf(spec->cgroup, sizeof(spec->cgroup), "%s/%s", CGROUP_ROOT, value);
+      isValid = yash_isCgroupNameValid(value) && length > 0 && (size_t)length < sizeof(spec->cgroup);
+    }
+
+    if (!isValid)
+    {
+      fprintf(stderr, "Error: Invalid launch modifier %s \n", cmdArgs[modifiers]);
+      return -1;
+    }
+    modifiers++;
+  }
+
+  // when only @node is given the job runs on the cpus of those nodes.
+  if (spec->hasNode && !spec->hasCpus)
+  {
+    CPU_ZERO(&spec->cpus);
+    for (long node = 0; node < MAX_NUMA_NODES; node++)
+    {
+      if (spec->nodeMask[node / (8 * sizeof(unsigned long))] & (1UL << (node % (8 * sizeof(unsigned long)))))
+      {
+        if (yash_addNodeCpus(node, &spec->cpus) == -1)
+        {
+          fprintf(stderr, "Error: NUMA node %ld does not exist \n", node);
+          return -1;
+        }
+      }
+    }
+    spec->hasCpus = CPU_COUNT(&spec->cpus) > 0;
+  }
+
+  if (modifiers == cmdArgsCount)
+  {
+    yash_logMessage("Error: Launch modifiers must be followed by a command.");
+    return -1;
+  }
+  return modifiers;
+}
+
+// this is the function called in the child after fork and before exec to apply
+// the launch modifiers. It uses the system calls directly so there is no need
+// of taskset, numactl or prlimit processes. If something can not be applied the
+// child exits instead of running the job without the requested placement.
+void yash_applyLaunchSpec(const yash_launchSpec *spec)
+{
+  // the cgroup is created if needed and joined first so the limits of the cgroup
+  // apply from the start.
+  if (spec->cgroup[0] != '\0')
+  {
+    if (mkdir(spec->cgroup, 0755) == -1 && errno != EEXIST)
+    {
+      yash_logMessage("Error: Could not create the cgroup of the command.");
+      _exit(EXIT_FAILURE);
+    }
+
+    char path[PATH_MAX + 16];
+    snprintf(path, sizeof(path), "%s/cgroup.procs", spec->cgroup);
+    int fileDescriptor = open(path, O_WRONLY | O_CLOEXEC);
+    if (fileDescriptor < 0 || write(fileDescriptor, "0", 1) != 1)
+    {
+      yash_logMessage("Error: Could not move the command to the cgroup.");
+      _exit(EXIT_FAILURE);
+    }
+    close(fileDescriptor);
+  }
+
+  if (spec->hasNode &&
+      syscall(SYS_set_mempolicy, MPOL_BIND, spec->nodeMask, (unsigned long)MAX_NUMA_NODES + 1) == -1)
+  {
+    yash_logMessage("Error: Could not bind the memory of the command to the NUMA node.");
+    _exit(EXIT_FAILURE);
+  }
+
+  if (spec->hasCpus && sched_setaffinity(0, sizeof(spec->cpus), &spec->cpus) == -1)
+  {
+    yash_logMessage("Error: Could not set the cpu affinity of the command.");
+    _exit(EXIT_FAILURE);
+  }
+
+  if (spec->hasNice && setpriority(PRIO_PROCESS, 0, spec->nice) == -1)
+  {
+    yash_logMessage("Error: Could not set the nice value of the command.");
+    _exit(EXIT_FAILURE);
+  }
+
+  for (int limit = 0; limit < spec->limitCount; limit++)
+  {
+    if (setrlimit(spec->limitResources[limit], &spec->limits[limit]) == -1)
+    {
+      yash_logMessage("Error: Could not set the resource limit of the command.");
+      _exit(EXIT_FAILURE);
+    }
+  }
+}
+
+// this is the function used to give the terminal to the process group of a command
+// which runs in its own group, so it can still read from the terminal and Ctrl-C
+// reaches it directly. It does nothing if the shell does not own the terminal.
+void yash_giveTerminal(pid_t processGroup)
+{
+  if (isatty(STDIN_FILENO) && tcgetpgrp(STDIN_FILENO) == getpgrp())
+  {
+    tcsetpgrp(STDIN_FILENO, processGroup);
+  }
+}
+
+// this is the function used to take the terminal back after the command is finished.
+// SIGTTOU is ignored by the shell so this works while the shell is not in the foreground.
+void yash_takeTerminal()
+{
+  if (isatty(STDIN_FILENO) && tcgetpgrp(STDIN_FILENO) != getpgrp())
+  {
+    tcsetpgrp(STDIN_FILENO, getpgrp());
+  }
+}
+
+// this is the function used to check if a command gets a deadline from the @deadline=
+// modifier or the timeout builtin, before it is started.
+int yash_hasDeadline(const yash_args *args)
+{
+  int index = 0;
+  for (; index < args->argc && args->argv[index][0] == '@'; index++)
+  {
+    if (strncmp(args->argv[index], "@deadline=", 10) == 0)
+    {
+      return 1;
+    }
+  }
+  return index < args->argc && strcmp(args->argv[index], "timeout") == 0;
+}
+
+// this is the function used to parse the timeout builtin: timeout [-k DURATION] DURATION command args
+// it stores the duration and the time to wait before SIGKILL and returns the number of
+// tokens used by the builtin so the rest is the command, or -1 if the syntax is wrong.
+int yash_parseTimeoutBuiltin(char **cmdArgs, int cmdArgsCount, int64_t *duration, int64_t *killAfter)
+{
+  int position = 1;
+  if (position + 1 < cmdArgsCount && strcmp(cmdArgs[position], "-k") == 0)
+  {
+    if (yash_parseDuration(cmdArgs[position + 1], killAfter) == -1)
+    {
+      yash_logMessage("Error: timeout: invalid kill after duration, it must be a positive finite number.");
+      return -1;
+    }
+    position += 2;
+  }
+
+  if (position >= cmdArgsCount)
+  {
+    yash_logMessage("Error: timeout: usage is timeout [-k DURATION] DURATION command [args]");
+    return -1;
+  }
+  if (yash_parseDuration(cmdArgs[position], duration) == -1)
+  {
+    yash_logMessage("Error: timeout: invalid duration, it must be a positive finite number.");
+    return -1;
+  }
+  position++;
+
+  if (position >= cmdArgsCount)
+  {
+    yash_logMessage("Error: timeout: missing command.");
+    return -1;
+  }
+  return position;
+}
+
+// this is the function used by the audit writer thread to write a part of the ring
+// from the tail to the given head, the ring can wrap so it is written with writev.
+// it returns the number of bytes written.
+uint64_t yash_auditWriteRing(uint64_t tail, uint64_t head)
+{
+  uint64_t written = 0;
+  while (tail + written < head)
+  {
+    uint64_t start = (tail + written) & (AUDIT_RING_SIZE - 1);
+    uint64_t pending = head - tail - written;
+    struct iovec parts[2];
+    int partCount = 1;
+
+    parts[0].iov_base = auditLog.ring + start;
+    parts[0].iov_len = pending;
+    if (start + pending > AUDIT_RING_SIZE)
+    {
+      parts[0].iov_len = AUDIT_RING_SIZE - start;
+      parts[1].iov_base = auditLog.ring;
+      parts[1].iov_len = pending - parts[0].iov_len;
+      partCount = 2;
+    }
+
+    ssize_t count = writev(auditLog.fileDescriptor, parts, partCount);
+    if (count < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (count <= 0)
+    {
+      break;
+    }
+    written += count;
+  }
+  return written;
+}
+
+// this is the background writer of the audit log. It sleeps on the eventfd
+// and wakes up at least every AUDIT_FLUSH_INTERVAL_MS, then writes everything
+// which is in the ring with one writev. fdatasync is called when AUDIT_SYNC_BYTES
+// are written or AUDIT_SYNC_INTERVAL_MS is passed since the last sync.
+void *yash_auditWriter(void *argument)
+{
+  (void)argument;
+  uint64_t bytesSinceSync = 0;
+  int64_t lastSync = yash_monotonicNanos();
+  struct pollfd wake = {auditLog.wakeFD, POLLIN, 0};
+
+  while (1)
+  {
+    poll(&wake, 1, AUDIT_FLUSH_INTERVAL_MS);
+    if (wake.revents & POLLIN)
+    {
+      uint64_t wakeups;
+      if (read(auditLog.wakeFD, &wakeups, sizeof(wakeups)) < 0)
+      {
+        wakeups = 0;
+      }
+    }
+
+    int isStopping = atomic_load_explicit(&auditLog.isStopping, memory_order_acquire);
+    uint64_t head = atomic_load_explicit(&auditLog.head, memory_order_acquire);
+    uint64_t tail = atomic_load_explicit(&auditLog.tail, memory_order_relaxed);
+
+    if (head != tail)
+    {
+      uint64_t written = yash_auditWriteRing(tail, head);
+      atomic_store_explicit(&auditLog.tail, tail + written, memory_order_release);
+      bytesSinceSync += written;
+    }
+
+    int64_t now = yash_monotonicNanos();
+    if (bytesSinceSync > 0 &&
+        (bytesSinceSync >= AUDIT_SYNC_BYTES || isStopping ||
+         now - lastSync >= AUDIT_SYNC_INTERVAL_MS * 1000000LL))
+    {
+      fdatasync(auditLog.fileDescriptor);
+      bytesSinceSync = 0;
+      lastSync = now;
+    }
+
+    // the shell sets isStopping after its last record so everything is written by now.
+    if (isStopping)
+    {
+      return NULL;
+    }
+  }
+}
+
+// this is the handler used when the shell is killed or crashes while auditing.
+// the records which are still in the ring are written and synced before the
+// signal is raised again. Only async signal safe calls are used here, if the
+// writer thread was in the middle of a write its last batch can be written twice.
+void yash_auditCrashHandler(int signalNumber)
+{
+  uint64_t tail = atomic_load_explicit(&auditLog.tail, memory_order_acquire);
+  uint64_t head = atomic_load_explicit(&auditLog.head, memory_order_acquire);
+  if (head != tail)
+  {
+    yash_auditWriteRing(tail, head);
+  }
+  fdatasync(auditLog.fileDescriptor);
+
+  signal(signalNumber, SIG_DFL);
+  raise(signalNumber);
+}
+
+// this is the function used to flush and stop the audit log when the shell exits.
+void yash_auditShutdown()
+{
+  if (!isAuditEnabled)
+  {
+    return;
+  }
+  isAuditEnabled = 0;
+
+  uint64_t wakeup = 1;
+  atomic_store_explicit(&auditLog.isStopping, 1, memory_order_release);
+  if (write(auditLog.wakeFD, &wakeup, sizeof(wakeup)) < 0)
+  {
+    wakeup = 0;
+  }
+  pthread_join(auditLog.writer, NULL);
+  close(auditLog.fileDescriptor);
+  close(auditLog.wakeFD);
+}
+
+// this is the function used to start the audit log for the given file.
+// the file is opened for append so several shells can share one log,
+// a new file starts with the AUDIT_FILE_MAGIC so the decoder can check it.
+int yash_auditStart(const char *path)
+{
+  auditLog.fileDescriptor = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+  if (auditLog.fileDescriptor < 0)
+  {
+    fprintf(stderr, "Error: Could not open audit log %s: %s \n", path, strerror(errno));
+    return -1;
+  }
+
+  struct stat fileInfo;
+  if (fstat(auditLog.fileDescriptor, &fileInfo) == 0 && fileInfo.st_size == 0 &&
+      write(auditLog.fileDescriptor, AUDIT_FILE_MAGIC, AUDIT_MAGIC_SIZE) != AUDIT_MAGIC_SIZE)
+  {
+    yash_logMessage("Error: Could not write the audit log header.");
+    close(auditLog.fileDescriptor);
+    return -1;
+  }
+
+  auditLog.ring = malloc(AUDIT_RING_SIZE);
+  auditLog.wakeFD = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  atomic_init(&auditLog.head, 0);
+  atomic_init(&auditLog.tail, 0);
+  atomic_init(&auditLog.isStopping, 0);
+
+  // the writer thread must not get the signals of the shell like SIGINT,
+  // so they are blocked while creating it and the thread inherits the mask.
+  sigset_t allSignals, previousSignals;
+  sigfillset(&allSignals);
+  pthread_sigmask(SIG_BLOCK, &allSignals, &previousSignals);
+  int result = pthread_create(&auditLog.writer, NULL, yash_auditWriter, NULL);
+  pthread_sigmask(SIG_SETMASK, &previousSignals, NULL);
+
+  if (auditLog.ring == NULL || auditLog.wakeFD < 0 || result != 0)
+  {
+    yash_logMessage("Error: Could not start the audit log writer.");
+    close(auditLog.fileDescriptor);
+    return -1;
+  }
+
+  isAuditEnabled = 1;
+  atexit(yash_auditShutdown);
+
+  int crashSignals[] = {SIGSEGV, SIGBUS, SIGABRT, SIGFPE, SIGILL, SIGTERM, SIGHUP};
+  for (unsigned long index = 0; index < sizeof(crashSignals) / sizeof(crashSignals[0]); index++)
+  {
+    signal(crashSignals[index], yash_auditCrashHandler);
+  }
+  return 0;
+}
+
+// this is the function used to add one record in the audit log for a command.
+// it only copies the record in the ring, the write to the file is done by the
+// writer thread so the shell is never waiting for the disk. The record is never
+// dropped, if the ring is full the shell waits for the writer to make space.
+void yash_auditRecord(uint16_t type, uint16_t flags, char **cmdArgs, int cmdArgsCount,
+                      int64_t startTime, int64_t duration, pid_t pid, int status)
+{
+  if (!isAuditEnabled)
+  {
+    return;
+  }
+
+  char cwd[PATH_MAX];
+  if (getcwd(cwd, sizeof(cwd)) == NULL)
+  {
+    cwd[0] = '\0';
+  }
+
+  yash_auditRecordHeader header;
+  header.type = type;
+  header.flags = flags;
+  header.cwdLength = strlen(cwd);
+  header.startTime = startTime;
+  header.duration = duration;
+  header.pid = pid;
+  header.status = status;
+
+  // the arguments which do not fit in the maximum record size are left out.
+  uint64_t length = sizeof(header) + header.cwdLength;
+  int argc = 0;
+  while (argc < cmdArgsCount)
+  {
+    uint64_t argumentLength = sizeof(uint32_t) + strlen(cmdArgs[argc]);
+    if (length + argumentLength > AUDIT_MAX_RECORD_SIZE)
+    {
+      header.flags |= AUDIT_FLAG_TRUNCATED;
+      break;
+    }
+    length += argumentLength;
+    argc++;
+  }
+  header.argc = argc;
+  header.length = (length + 7) & ~7ULL;
+
+  // building the record in one buffer before copying it in the ring.
+  char record[AUDIT_MAX_RECORD_SIZE + 8];
+  char *writer = record;
+  memcpy(writer, &header, sizeof(header));
+  writer += sizeof(header);
+  memcpy(writer, cwd, header.cwdLength);
+  writer += header.cwdLength;
+  for (int argument = 0; argument < argc; argument++)
+  {
+    uint32_t argumentLength = strlen(cmdArgs[argument]);
+    memcpy(writer, &argumentLength, sizeof(argumentLength));
+    writer += sizeof(argumentLength);
+    memcpy(writer, cmdArgs[argument], argumentLength);
+    writer += argumentLength;
+  }
+  memset(writer, 0, record + header.length - writer);
+
+  // a forked shell has no writer thread, so the record is appended directly,
+  // it is one write of a whole record so it does not mix with other records.
+  if (isAuditDirect)
+  {
+    if (write(auditLog.fileDescriptor, record, header.length) < 0)
+    {
+      yash_logMessage("Error: Could not write the audit record.");
+    }
+    return;
+  }
+
+  uint64_t head = atomic_load_explicit(&auditLog.head, memory_order_relaxed);
+  uint64_t wakeup = 1;
+  while (head + header.length - atomic_load_explicit(&auditLog.tail, memory_order_acquire) > AUDIT_RING_SIZE)
+  {
+    if (write(auditLog.wakeFD, &wakeup, sizeof(wakeup)) < 0)
+    {
+      sched_yield();
+    }
+    poll(NULL, 0, 1);
+  }
+
+  // copying the record in the ring, taking care of the wrap around.
+  uint64_t start = head & (AUDIT_RING_SIZE - 1);
+  uint64_t firstPart = header.length;
+  if (start + firstPart > AUDIT_RING_SIZE)
+  {
+    firstPart = AUDIT_RING_SIZE - start;
+  }
+  memcpy(auditLog.ring + start, record, firstPart);
+  memcpy(auditLog.ring, record + firstPart, header.length - firstPart);
+
+  atomic_store_explicit(&auditLog.head, head + header.length, memory_order_release);
+
+  // the writer is only woken up early when the ring is filling up,
+  // otherwise it picks the records on its next interval.
+  if (head + header.length - atomic_load_explicit(&auditLog.tail, memory_order_relaxed) >= AUDIT_WAKE_BYTES &&
+      write(auditLog.wakeFD, &wakeup, sizeof(wakeup)) < 0)
+  {
+    wakeup = 0;
+  }
+}
+
+// this is the function called in a child of the shell which keeps running shell code
+// after fork. Only the thread calling fork exists in the child so the records are
+// written directly, and the copy of the ring is emptied as the shell writes those records.
+void yash_auditAfterFork()
+{
+  if (!isAuditEnabled)
+  {
+    return;
+  }
+  isAuditDirect = 1;
+  atomic_store_explicit(&auditLog.tail, atomic_load_explicit(&auditLog.head, memory_order_relaxed), memory_order_relaxed);
+}
+
+// this is the function used to get the realtime clock in nanoseconds for the audit records.
+int64_t yash_realtimeNanos()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// this is the function used to print a string for the audit decoder,
+// in json mode it is quoted and escaped.
+void yash_auditPrintString(const char *text, uint32_t length, int isJson)
+{
+  if (!isJson)
+  {
+    fwrite(text, 1, length, stdout);
+    return;
+  }
+
+  putchar('"');
+  for (uint32_t index = 0; index < length; index++)
+  {
+    unsigned char character = text[index];
+    if (character == '"' || character == '\\')
+    {
+      printf("\\%c", character);
+    }
+    else if (character < 0x20)
+    {
+      printf("\\u%04x", character);
+    }
+    else
+    {
+      putchar(character);
+    }
+  }
+  putchar('"');
+}
+
+// this is the function used to decode an audit log into text or json lines.
+// usage: yash --audit-decode FILE [--json]
+int yash_auditDecode(const char *path, int isJson)
+{
+  static const char *recordTypes[] = {"", "command", "background", "background-exit"};
+
+  int fileDescriptor = open(path, O_RDONLY | O_CLOEXEC);
+  struct stat fileInfo;
+  if (fileDescriptor < 0 || fstat(fileDescriptor, &fileInfo) == -1)
+  {
+    yash_logMessage("Error: There was some error opening the audit log. Check if the file exist.");
+    return EXIT_FAILURE;
+  }
+  if (fileInfo.st_size < AUDIT_MAGIC_SIZE)
+  {
+    yash_logMessage("Error: Not a yash audit log.");
+    close(fileDescriptor);
+    return EXIT_FAILURE;
+  }
+
+  char *data = mmap(NULL, fileInfo.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+  close(fileDescriptor);
+  if (data == MAP_FAILED || memcmp(data, AUDIT_FILE_MAGIC, AUDIT_MAGIC_SIZE) != 0)
+  {
+    yash_logMessage("Error: Not a yash audit log.");
+    return EXIT_FAILURE;
+  }
+
+  size_t position = AUDIT_MAGIC_SIZE;
+  int result = EXIT_SUCCESS;
+  while (position + sizeof(yash_auditRecordHeader) <= (size_t)fileInfo.st_size)
+  {
+    yash_auditRecordHeader header;
+    memcpy(&header, data + position, sizeof(header));
+    if (header.length < sizeof(header) || header.length % 8 != 0 ||
+        header.length > fileInfo.st_size - position ||
+        sizeof(header) + header.cwdLength > header.length)
+    {
+      fprintf(stderr, "Error: Corrupted audit record at offset %zu \n", position);
+      result = EXIT_FAILURE;
+      break;
+    }
+
+    const char *reader = data + position + sizeof(header);
+    const char *recordEnd = data + position + header.length;
+    const char *type = header.type < sizeof(recordTypes) / sizeof(recordTypes[0]) ? recordTypes[header.type] : "unknown";
+
+    char timestamp[64];
+    time_t seconds = header.startTime / 1000000000LL;
+    struct tm utc;
+    gmtime_r(&seconds, &utc);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", &utc);
+
+    char statusText[32];
+    if (header.status == -1)
+    {
+      snprintf(statusText, sizeof(statusText), "unknown");
+    }
+    else if (WIFSIGNALED(header.status))
+    {
+      snprintf(statusText, sizeof(statusText), "signal:%d", WTERMSIG(header.status));
+    }
+    else
+    {
+      snprintf(statusText, sizeof(statusText), "exit:%d", WEXITSTATUS(header.status));
+    }
+
+    if (isJson)
+    {
+      printf("{\"time\":\"%s.%09lldZ\",\"type\":\"%s\",\"pid\":%d,\"status\":\"%s\",\"duration_ns\":%lld,"
+             "\"timed_out\":%s,\"truncated\":%s,\"builtin\":%s,\"cwd\":",
+             timestamp, (long long)(header.startTime % 1000000000LL), type, header.pid, statusText,
+             (long long)header.duration, header.flags & AUDIT_FLAG_TIMED_OUT ? "true" : "false",
+             header.flags & AUDIT_FLAG_TRUNCATED ? "true" : "false",
+             header.flags & AUDIT_FLAG_BUILTIN ? "true" : "false");
+    }
+    else
+    {
+      printf("%s.%09lldZ %s pid=%d status=%s duration=%.6fs%s%s%s cwd=",
+             timestamp, (long long)(header.startTime % 1000000000LL), type, header.pid, statusText,
+             header.duration / 1e9, header.flags & AUDIT_FLAG_TIMED_OUT ? " timed-out" : "",
+             header.flags & AUDIT_FLAG_TRUNCATED ? " truncated" : "",
+             header.flags & AUDIT_FLAG_BUILTIN ? " builtin" : "");
+    }
+    yash_auditPrintString(reader, header.cwdLength, isJson);
+    reader += header.cwdLength;
+
+    printf(isJson ? ",\"argv\":[" : " argv:");
+    for (uint32_t argument = 0; argument < header.argc; argument++)
+    {
+      uint32_t argumentLength;
+      if (reader + sizeof(argumentLength) > recordEnd)
+      {
+        break;
+      }
+      memcpy(&argumentLength, reader, sizeof(argumentLength));
+      reader += sizeof(argumentLength);
+      if (argumentLength > (size_t)(recordEnd - reader))
+      {
+        break;
+      }
+      printf(isJson ? (argument > 0 ? "," : "") : " ");
+      yash_auditPrintString(reader, argumentLength, isJson);
+      reader += argumentLength;
+    }
+    printf(isJson ? "]}\n" : "\n");
+
+    position += header.length;
+  }
+
+  munmap(data, fileInfo.st_size);
+  return result;
+}
+
+// this is the function used to get the exit status of a child from its wait status,
+// a child killed by a signal gets 128 and the number of the signal like in other shells.
+int yash_exitStatus(int waitStatus)
+{
+  if (WIFSIGNALED(waitStatus))
+  {
+    return 128 + WTERMSIG(waitStatus);
+  }
+  return WEXITSTATUS(waitStatus);
+}
+
+// this is the function used to send a signal to the process group of a child at its deadline.
+// a group of 0 or 1 would be the group of the shell or every process, so a child without
+// a group of its own only gets the signal itself and the shell never kills itself.
+void yash_signalChild(const yash_child *child, int signalNumber)
+{
+  if (child->processGroup > 1)
+  {
+    kill(-child->processGroup, signalNumber);
+  }
+  else
+  {
+    kill(child->pid, signalNumber);
+  }
+}
+
+// this is the function used to wait for the children of a command or a pipeline.
+// the children with a deadline must be in their own process group. The wait is
+// done with a pidfd for each child and one timerfd in poll so there is no helper process
+// or sleeping, and as a child is not reaped before it exits its pid and process group id can
+// not be reused while signals are sent. When the deadline of a child passes its whole group
+// gets SIGTERM and after killAfter nanoseconds SIGKILL. The status of each child is stored
+// in the list and every command is recorded in the audit log.
+void yash_waitChildren(yash_child *children, int childCount)
+{
+  int hasDeadline = 0;
+  for (int index = 0; index < childCount; index++)
+  {
+    hasDeadline |= children[index].deadline != 0;
+  }
+
+  int timerFD = -1;
+  int pidFDs[childCount > 0 ? childCount : 1];
+  if (hasDeadline)
+  {
+    timerFD = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    for (int index = 0; index < childCount; index++)
+    {
+      pidFDs[index] = syscall(SYS_pidfd_open, children[index].pid, 0);
+      if (pidFDs[index] < 0)
+      {
+        timerFD = timerFD >= 0 ? (close(timerFD), -1) : -1;
+      }
+    }
+    if (timerFD < 0)
+    {
+      yash_logMessage("Error: Could not watch the command for timeout, waiting without deadline.");
+      for (int index = 0; index < childCount; index++)
+      {
+        if (pidFDs[index] >= 0)
+        {
+          close(pidFDs[index]);
+        }
+      }
+    }
+  }
+
+  if (timerFD < 0)
+  {
+    for (int index = 0; index < childCount; index++)
+    {
+      while (waitpid(children[index].pid, &children[index].status, 0) == -1 && errno == EINTR)
+      {
+      }
+    }
+  }
+  else
+  {
+    // here isTimedOut counts the signals sent to the child, and killTime is
+    // when SIGKILL is sent after SIGTERM.
+    int64_t killTimes[childCount];
+    int pending = childCount;
+    while (pending > 0)
+    {
+      // the timer is armed with the absolute time of the next signal to send, so the
+      // time already used by the previous commands of the pipeline is counted.
+      int64_t nextSignal = 0;
+      struct pollfd watched[childCount + 1];
+      int watchedChildren[childCount];
+      int watchedCount = 0;
+      for (int index = 0; index < childCount; index++)
+      {
+        if (pidFDs[index] < 0)
+        {
+          continue;
+        }
+        int64_t signalTime = children[index].isTimedOut == 0 ? children[index].deadline
+                             : children[index].isTimedOut == 1 ? killTimes[index]
+                                                               : 0;
+        if (signalTime != 0 && (nextSignal == 0 || signalTime < nextSignal))
+        {
+          nextSignal = signalTime;
+        }
+        watched[watchedCount] = (struct pollfd){pidFDs[index], POLLIN, 0};
+        watchedChildren[watchedCount] = index;
+        watchedCount++;
+      }
+      struct itimerspec timer = {{0, 0}, {nextSignal / 1000000000LL, nextSignal % 1000000000LL}};
+      timerfd_settime(timerFD, TFD_TIMER_ABSTIME, &timer, NULL);
+      watched[watchedCount] = (struct pollfd){timerFD, POLLIN, 0};
+
+      if (poll(watched, watchedCount + 1, -1) == -1)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+        break;
+      }
+
+      // a child has exited, if it was timed out I am also killing what is left
+      // in its group before reaping the leader which keeps the group id reserved.
+      for (int watchedIndex = 0; watchedIndex < watchedCount; watchedIndex++)
+      {
+        int index = watchedChildren[watchedIndex];
+        if (watched[watchedIndex].revents & POLLIN)
+        {
+          if (children[index].isTimedOut > 0)
+          {
+            yash_signalChild(&children[index], SIGKILL);
+          }
+          close(pidFDs[index]);
+          pidFDs[index] = -1;
+          pending--;
+          while (waitpid(children[index].pid, &children[index].status, 0) == -1 && errno == EINTR)
+          {
+          }
+        }
+      }
+
+      if (watched[watchedCount].revents & POLLIN)
+      {
+        uint64_t expirations;
+        if (read(timerFD, &expirations, sizeof(expirations)) < 0)
+        {
+          continue;
+        }
+
+        int64_t now = yash_monotonicNanos();
+        for (int index = 0; index < childCount; index++)
+        {
+          yash_child *child = &children[index];
+          if (pidFDs[index] < 0)
+          {
+            continue;
+          }
+          if (child->isTimedOut == 0 && child->deadline != 0 && now >= child->deadline)
+          {
+            // SIGCONT wakes up the group if it was stopped so it can handle SIGTERM.
+            yash_signalChild(child, SIGTERM);
+            yash_signalChild(child, SIGCONT);
+            killTimes[index] = now + child->killAfter;
+            child->isTimedOut = 1;
+          }
+          else if (child->isTimedOut == 1 && now >= killTimes[index])
+          {
+            yash_signalChild(child, SIGKILL);
+            child->isTimedOut = 2;
+          }
+        }
+      }
+    }
+    close(timerFD);
+  }
+
+  for (int index = 0; index < childCount; index++)
+  {
+    yash_child *child = &children[index];
+    if (child->cmdArgs == NULL)
+    {
+      continue;
+    }
+    yash_auditRecord(AUDIT_RECORD_COMMAND, child->isTimedOut ? AUDIT_FLAG_TIMED_OUT : 0, child->cmdArgs,
+                     child->cmdArgsCount, child->startTime, yash_monotonicNanos() - child->startClock,
+                     child->pid, child->status);
+    if (child->isTimedOut)
+    {
+      fprintf(stderr, "yash: timeout: %s exceeded the deadline and was stopped by %s \n", child->cmdArgs[0],
+              WIFSIGNALED(child->status) && WTERMSIG(child->status) == SIGKILL ? "SIGKILL" : "SIGTERM");
+    }
+  }
+}
+
+// this is the function used to get the exit status of a child after the wait,
+// a command stopped at its deadline exits with TIMEOUT_EXIT_STATUS like the timeout command.
+int yash_childStatus(const yash_child *child)
+{
+  return child->isTimedOut ? TIMEOUT_EXIT_STATUS : yash_exitStatus(child->status);
+}
+
+// this is the function used to apply the redirection plan of a command, after the pipes
+// are connected so 2>&1 | sends stderr in the pipe too. The files are opened with O_CLOEXEC
+// and moved to their fd, if a file can not be opened the error is printed and -1 returned.
+int yash_applyRedirects(const yash_redirectPlan *plan)
+{
+  for (int index = 0; plan != NULL && index < plan->count; index++)
+  {
+    const yash_redirect *redirect = &plan->redirects[index];
+    if (redirect->type == REDIRECT_CLOSE)
+    {
+      close(redirect->fd);
+      continue;
+    }
+    if (redirect->type == REDIRECT_DUPLICATE)
+    {
+      if (fcntl(redirect->targetFD, F_GETFD) == -1 || dup2(redirect->targetFD, redirect->fd) == -1)
+      {
+        fprintf(stderr, "yash: %d: Bad file descriptor \n", redirect->targetFD);
+        return -1;
+      }
+      continue;
+    }
+
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+    if (redirect->type == REDIRECT_INPUT)
+    {
+      flags = O_RDONLY;
+    }
+    else if (redirect->type == REDIRECT_APPEND || redirect->type == REDIRECT_APPEND_ALL)
+    {
+      flags = O_WRONLY | O_CREAT | O_APPEND;
+    }
+
+    int fileDescriptor = open(redirect->path, flags | O_CLOEXEC, 0666);
+    if (fileDescriptor < 0)
+    {
+      fprintf(stderr, "yash: %s: %s \n", redirect->path, strerror(errno));
+      return -1;
+    }
+
+    // if the file got the fd it is meant for the close on exec flag is cleared
+    // as dup2 is not called, otherwise dup2 gives a copy without the flag.
+    if (fileDescriptor == redirect->fd)
+    {
+      fcntl(fileDescriptor, F_SETFD, 0);
+    }
+    else
+    {
+      dup2(fileDescriptor, redirect->fd);
+      close(fileDescriptor);
+    }
+
+    if (redirect->type == REDIRECT_OUTPUT_ALL || redirect->type == REDIRECT_APPEND_ALL)
+    {
+      dup2(redirect->fd, STDERR_FILENO);
+    }
+  }
+  return 0;
+}
+
+// this is the function used in the child to apply the redirection plan, if a file can
+// not be opened the child exits with 1 like other shells do.
+void yash_applyRedirectPlan(const yash_redirectPlan *plan)
+{
+  if (yash_applyRedirects(plan) == -1)
+  {
+    _exit(1);
+  }
+}
+
+// this is the function used in the child to put the assignments written
+// before the command in its environment.
+void yash_applyEnvironment(const yash_args *args)
+{
+  for (int index = 0; index < args->environmentCount; index++)
+  {
+    putenv(args->environment[index]);
+  }
+}
+
+// this is the function which is used to start a particular linux command
+// it creates the args vector based on parameters passed and execute the command
+// using execvp under a child process so the parent process does not terminate.
+// inFD and outFD are connected to the stdin and stdout of the child when they are not -1
+// and closeFD is closed in the child, then the redirection plan is applied if there is one.
+// the assignments before the command are put in its environment in the child.
+// It returns 0 when the child is started, it is then stored in child to be waited,
+// otherwise the exit status of the command which failed.
+int yash_spawnCommand(const yash_args *args, int inFD, int outFD, int closeFD,
+                      const yash_redirectPlan *plan, yash_child *child)
+{
+  memset(child, 0, sizeof(*child));
+  char **cmdArgs = args->argv;
+  int cmdArgsCount = args->argc;
+
+  // the launch modifiers at the start are removed from the arguments.
+  yash_launchSpec launchSpec;
+  int modifiers = yash_parseLaunchModifiers(cmdArgs, cmdArgsCount, &launchSpec);
+  if (modifiers == -1)
+  {
+    return 1;
+  }
+  cmdArgs += modifiers;
+  cmdArgsCount -= modifiers;
+  char *command = cmdArgs[0];
+
+  // the @deadline= modifier starts the deadline of the whole pipeline, so the
+  // next stages of a pipeline only get the time which is left.
+  if (launchSpec.deadline != 0 && pipelineDeadline == 0)
+  {
+    pipelineDeadline = yash_monotonicNanos() + launchSpec.deadline;
+  }
+  int64_t deadline = pipelineDeadline;
+  int64_t killAfter = TIMEOUT_KILL_AFTER_NANOS;
+
+  // the timeout builtin gives a deadline to only this command.
+  if (strcmp(command, "timeout") == 0)
+  {
+    int64_t duration;
+    int builtinTokens = yash_parseTimeoutBuiltin(cmdArgs, cmdArgsCount, &duration, &killAfter);
+    if (builtinTokens == -1)
+    {
+      return TIMEOUT_FAILED_STATUS;
+    }
+    cmdArgs += builtinTokens;
+    cmdArgsCount -= builtinTokens;
+    command = cmdArgs[0];
+
+    int64_t commandDeadline = yash_monotonicNanos() + duration;
+    if (deadline == 0 || commandDeadline < deadline)
+    {
+      deadline = commandDeadline;
+    }
+  }
+
+  // if the deadline of the pipeline is already over the next stages are not started.
+  if (deadline != 0 && yash_monotonicNanos() >= deadline)
+  {
+    fprintf(stderr, "yash: timeout: %s was not started, the deadline is over \n", command);
+    return TIMEOUT_EXIT_STATUS;
+  }
+
+  // create the args vector of size arguments length + 1
+  // extra length is for the NULL character required by execvp.
+  char *argsVector[cmdArgsCount + 1];
+
+  // iterate over the command arguments and store it in argsVector.
+  for (int args = 0; args < cmdArgsCount; args++)
+  {
+    argsVector[args] = cmdArgs[args];
+  }
+
+  // add the NULL character at the end
+  argsVector[cmdArgsCount] = NULL;
+
+  // a command with a deadline runs in a process group which can be signalled when the
+  // deadline is over, the group of its pipeline if it has one or else its own group.
+  pid_t processGroup = deadline != 0 && pipelineGroup == -1 ? 0 : pipelineGroup;
+
+  // the start time is taken for the audit log.
+  int64_t startTime = yash_realtimeNanos();
+  int64_t startClock = yash_monotonicNanos();
+
+  // create a child using fork
+  pid_t pid = fork();
+
+  // check if there is some issue while creating the child
+  if (pid == -1)
+  {
+    yash_logMessage("Error while creating child to execute a command.");
+    return 1;
+  }
+
+  // now in the child process connect the pipes, apply the launch modifiers
+  // and execute the command using execvp
+  if (pid == 0)
+  {
+    if (inFD != -1)
+    {
+      dup2(inFD, STDIN_FILENO);
+      close(inFD);
+    }
+    if (outFD != -1)
+    {
+      dup2(outFD, STDOUT_FILENO);
+      close(outFD);
+    }
+    if (closeFD != -1)
+    {
+      close(closeFD);
+    }
+    yash_applyRedirectPlan(plan);
+    yash_applyEnvironment(args);
+
+    if (processGroup != -1)
+    {
+      setpgid(0, processGroup);
+    }
+    signal(SIGTTOU, SIG_DFL);
+    yash_applyLaunchSpec(&launchSpec);
+
+    // checking if the execvp failed and printing error message.
+    // the child exits here so it never continues as a copy of the shell.
+    if (execvp(command, argsVector) == -1)
+    {
+      yash_logMessage("Error while executing the command: Invalid command or arguments.");
+      _exit(127);
+    }
+  }
+
+  // setpgid is also called in the parent so the group exists before
+  // the terminal is given to it, whichever of the two runs first.
+  if (processGroup != -1)
+  {
+    processGroup = processGroup == 0 ? pid : processGroup;
+    setpgid(pid, processGroup);
+    pipelineGroup = pipelineGroup == 0 ? processGroup : pipelineGroup;
+  }
+
+  child->pid = pid;
+  child->processGroup = processGroup;
+  child->deadline = deadline;
+  child->killAfter = killAfter;
+  child->startTime = startTime;
+  child->startClock = startClock;
+  child->cmdArgs = cmdArgs;
+  child->cmdArgsCount = cmdArgsCount;
+  return 0;
+}
+
+// this is the function which is used to execute a particular linux command
+// with its redirections and wait for it, it returns the exit status of the command.
+int yash_executeCommand(const yash_args *args, const yash_redirectPlan *plan)
+{
+  yash_child child;
+  int result = yash_spawnCommand(args, -1, -1, -1, plan, &child);
+  if (result != 0)
+  {
+    return result;
+  }
+
+  // a command with a deadline is in its own process group so it gets the terminal.
+  if (child.deadline != 0)
+  {
+    yash_giveTerminal(child.processGroup);
+  }
+  yash_waitChildren(&child, 1);
+  if (child.deadline != 0)
+  {
+    yash_takeTerminal();
+  }
+  return yash_childStatus(&child);
+}
+
+// this is the function used to open a new session of the terminal.
+// this uses x-terminal-emulator command to execute the shell file.
+// internally its calling yash_executeCommand function
+int yash_openNewSession()
+{
+  char *argv[] = {"x-terminal-emulator", "-e", "./yash", NULL};
+  yash_args args = {argv, 3, NULL, 0, NULL, 0, 0};
+  return yash_executeCommand(&args, NULL);
+}
+
+// this is the function used to store the pid of a background process with its
+// description in the global list used by fg and wait. The start is recorded in the
+// audit log here as the shell does not wait for it.
+void yash_addBackgroundProcess(pid_t child, char *processDetails, char **cmdArgs, int cmdArgsCount,
+                               int64_t startTime, int64_t startClock)
+{
+  yash_auditRecord(AUDIT_RECORD_BACKGROUND, 0, cmdArgs, cmdArgsCount, startTime, 0, child, -1);
+  if (bgProcessListPointer + 1 >= MAX_BACKGROUND_PROCESSES)
+  {
+    yash_logMessage("Error: Too many background processes, it will not be available for fg and wait.");
+    free(processDetails);
+    return;
+  }
+  bgProcessListPointer++;
+  bgProcessIds[bgProcessListPointer] = child;
+  bgProcessNames[bgProcessListPointer] = processDetails;
+  bgProcessStartTimes[bgProcessListPointer] = startTime;
+  bgProcessStartClocks[bgProcessListPointer] = startClock;
+  bgProcessArgCounts[bgProcessListPointer] = cmdArgsCount;
+  bgProcessArgs[bgProcessListPointer] = malloc(sizeof(char *) * (cmdArgsCount > 0 ? cmdArgsCount : 1));
+  for (int index = 0; index < cmdArgsCount; index++)
+  {
+    bgProcessArgs[bgProcessListPointer][index] = strdup(cmdArgs[index]);
+  }
+
+  yash_logMessage("Background Process:");
+  yash_logMessage(processDetails);
+}
+
+// this is the function used when fg or wait reaps a background process, it writes
+// the record of its end with the real status and duration in the audit log.
+void yash_auditBackgroundExit(int index, int status)
+{
+  yash_auditRecord(AUDIT_RECORD_BACKGROUND_EXIT, 0, bgProcessArgs[index], bgProcessArgCounts[index],
+                   bgProcessStartTimes[index], yash_monotonicNanos() - bgProcessStartClocks[index],
+                   bgProcessIds[index], status);
+}
+
+// this is the function used to free a background process of the list.
+void yash_freeBackgroundProcess(int index)
+{
+  for (int argument = 0; argument < bgProcessArgCounts[index]; argument++)
+  {
+    free(bgProcessArgs[index][argument]);
+  }
+  free(bgProcessArgs[index]);
+  free(bgProcessNames[index]);
+  bgProcessArgs[index] = NULL;
+  bgProcessNames[index] = NULL;
+  bgProcessIds[index] = -1;
+}
+
+// this is the function used to execute the command in background
+// when & operator is used basically is creates a new child for the
+// command with a different session and the parent is not waiting for it.
+// also I am storing its pid for future use by other commands.
+int yash_execute_in_bg(const yash_args *args, const yash_redirectPlan *plan)
+{
+  char **cmdArgs = args->argv;
+  int cmdArgsCount = args->argc;
+
+  // the launch modifiers at the start are removed from the arguments.
+  yash_launchSpec launchSpec;
+  int modifiers = yash_parseLaunchModifiers(cmdArgs, cmdArgsCount, &launchSpec);
+  if (modifiers == -1)
+  {
+    return 1;
+  }
+  cmdArgs += modifiers;
+  cmdArgsCount -= modifiers;
+  char *command = cmdArgs[0];
+
+  // the deadlines are enforced while the shell waits for the command, which it does
+  // not do for a background job, so they are refused instead of being ignored.
+  if (launchSpec.deadline != 0 || strcmp(command, "timeout") == 0)
+  {
+    yash_logMessage("Error: @deadline= and timeout can not be used with a background job.");
+    return TIMEOUT_FAILED_STATUS;
+  }
+
+  // create the args vector of size arguments length + 1
+  // extra length is for the NULL character required by execvp.
+  char *argsVector[cmdArgsCount + 1];
+
+  // iterate over the command arguments and store it in argsVector.
+  for (int args = 0; args < cmdArgsCount; args++)
+  {
+    argsVector[args] = cmdArgs[args];
+  }
+
+  // add the NULL character at the end
+  argsVector[cmdArgsCount] = NULL;
+
+  // the start time is taken for the audit log.
+  int64_t startTime = yash_realtimeNanos();
+  int64_t startClock = yash_monotonicNanos();
+
+  // creating the child using fork
+  int child = fork();
+  if (child < 0)
+  {
+    yash_logMessage("Error creating child for bg process.");
+    return 1;
+  }
+
+  // in the child process create a new session using setsid and
+  //  then call execute with the particular command
+  if (child == 0)
+  {
+    if (setsid() == -1)
+    {
+      yash_logMessage("Error starting a session for new child process for bg command.");
+      _exit(1);
+    }
+    signal(SIGTTOU, SIG_DFL);
+    yash_applyRedirectPlan(plan);
+    yash_applyEnvironment(args);
+    yash_applyLaunchSpec(&launchSpec);
+    execvp(command, argsVector);
+    yash_logMessage("Error while executing the command: Invalid command or arguments.");
+    _exit(127);
+  }
+
+  // below code prints the process id with the process name for the process
+  // which will be running in background. also store that string in global variable for future use.
+  char childID[50];
+  sprintf(childID, "%d", child);
+
+  size_t detailsLength = strlen(childID) + 4;
+  for (int args = 0; args < cmdArgsCount; args++)
+  {
+    detailsLength += strlen(cmdArgs[args]) + 1;
+  }
+
+  char *processDetails = malloc(sizeof(char) * detailsLength);
+  processDetails = strcpy(processDetails, "[");
+  processDetails = strcat(processDetails, childID);
+  processDetails = strcat(processDetails, "]");
+
+  for (int args = 0; args < cmdArgsCount; args++)
+  {
+    processDetails = strcat(processDetails, " ");
+    processDetails = strcat(processDetails, cmdArgs[args]);
+  }
+
+  yash_addBackgroundProcess(child, processDetails, cmdArgs, cmdArgsCount, startTime, startClock);
+  return 0;
+}
+
+// the watch builtins run a part of the tree in a child using the executor, it is
+// declared here as the executor itself calls the builtins.
+int yash_executeNode(const yash_ast *ast, uint32_t node);
+
+// this is the function used to start one run of the watched command. The command is
+// executed by a child of the shell with the normal executor in its own process group,
+// so the whole run can be stopped with one signal. Its stdin is /dev/null as it is not
+// in the foreground of the terminal. It returns the pid and stores a pidfd for it.
+pid_t yash_startWatchedRun(const yash_ast *ast, uint32_t node, int *pidFD)
+{
+  fflush(NULL);
+  pid_t child = fork();
+  if (child == -1)
+  {
+    yash_logMessage("Error while creating child to execute a command.");
+    return -1;
+  }
+
+  if (child == 0)
+  {
+    setpgid(0, 0);
+    signal(SIGINT, SIG_DFL);
+    yash_auditAfterFork();
+
+    int nullFD = open("/dev/null", O_RDONLY);
+    if (nullFD >= 0)
+    {
+      dup2(nullFD, STDIN_FILENO);
+      close(nullFD);
+    }
+
+    int status = yash_executeNode(ast, node);
+    fflush(NULL);
+    _exit(status);
+  }
+
+  setpgid(child, child);
+  *pidFD = syscall(SYS_pidfd_open, child, 0);
+  if (*pidFD < 0)
+  {
+    yash_logMessage("Error: Could not watch the command, pidfd_open is not supported.");
+    kill(-child, SIGKILL);
+    waitpid(child, NULL, 0);
+    return -1;
+  }
+  return child;
+}
+
+// this is the function used to cancel a run which is still going, the whole process group
+// gets SIGTERM and then SIGKILL in the same way as the timeout builtin.
+void yash_stopWatchedRun(pid_t child, int pidFD)
+{
+  yash_child run;
+  memset(&run, 0, sizeof(run));
+  run.pid = child;
+  run.processGroup = child;
+  run.deadline = yash_monotonicNanos();
+  run.killAfter = TIMEOUT_KILL_AFTER_NANOS;
+  close(pidFD);
+  yash_waitChildren(&run, 1);
+}
+
+// this is the function used to reap a run which has finished and print its status.
+void yash_finishWatchedRun(const char *builtin, pid_t child, int pidFD)
+{
+  int status = 0;
+  close(pidFD);
+  while (waitpid(child, &status, 0) == -1 && errno == EINTR)
+  {
+  }
+
+  if (WIFSIGNALED(status))
+  {
+    fprintf(stderr, "yash: %s: run was killed by signal %d \n", builtin, WTERMSIG(status));
+  }
+}
+
+// this is the handler for SIGINT while watch or onchange is running.
+void yash_handleWatchInterrupt(int signalNumber)
+{
+  (void)signalNumber;
+  isWatchInterrupted = 1;
+}
+
+// this is the function used to set the SIGINT handler of the watch builtins
+// for the time they run, the previous handler is stored to restore it later.
+// SIGINT is left alone if it is ignored, like for a shell started in background.
+void yash_beginWatching(struct sigaction *previousAction)
+{
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = yash_handleWatchInterrupt;
+  sigemptyset(&action.sa_mask);
+
+  isWatchInterrupted = 0;
+  sigaction(SIGINT, NULL, previousAction);
+  if (previousAction->sa_handler != SIG_IGN)
+  {
+    sigaction(SIGINT, &action, NULL);
+  }
+}
+
+// this is the function used to print the header of each run of watch like the watch command.
+void yash_printWatchHeader(double interval, const char *commandText)
+{
+  char timeText[64];
+  time_t now = time(NULL);
+  struct tm local;
+  localtime_r(&now, &local);
+  strftime(timeText, sizeof(timeText), "%a %b %e %H:%M:%S %Y", &local);
+
+  // the screen is cleared only when the output is the terminal.
+  if (isatty(STDOUT_FILENO))
+  {
+    printf("\033[H\033[2J");
+  }
+  printf("Every %.1fs: %s    %s\n\n", interval, commandText, timeText);
+  fflush(stdout);
+}
+
+// this is the watch builtin: watch [-n SECONDS] command
+// args are the words of the builtin before the command, which is the node of the tree.
+// it runs the command again every interval until Ctrl-C. The wait uses a timerfd
+// and the pidfd of the run, so the shell does not use any CPU between runs.
+// The next run starts one interval after the start of the previous one, or as soon
+// as the previous one finishes if it took longer than the interval.
+int yash_watch(char **args, int argc, const char *commandText, const yash_ast *ast, uint32_t node)
+{
+  double interval = 2.0;
+  int isValid = argc == 1;
+  if (argc == 3 && strcmp(args[1], "-n") == 0)
+  {
+    char *end;
+    interval = strtod(args[2], &end);
+    isValid = end != args[2] && *end == '\0' && interval >= 0.1;
+  }
+  if (!isValid)
+  {
+    yash_logMessage("Error: watch: usage is watch [-n SECONDS] command");
+    return 2;
+  }
+  int64_t intervalNanos = (int64_t)(interval * 1e9);
+
+  int timerFD = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+  if (timerFD < 0)
+  {
+    yash_logMessage("Error: watch: could not create the timer.");
+    return 1;
+  }
+
+  struct sigaction previousAction;
+  yash_beginWatching(&previousAction);
+
+  pid_t child = -1;
+  int pidFD = -1;
+  int status = 0;
+  int64_t nextRun = yash_monotonicNanos();
+  struct itimerspec timer = {{0, 0}, {nextRun / 1000000000LL, nextRun % 1000000000LL}};
+  timerfd_settime(timerFD, TFD_TIMER_ABSTIME, &timer, NULL);
+
+  while (!isWatchInterrupted)
+  {
+    // only a signal can interrupt the wait, any other error would happen again
+    // on each call so the builtin stops instead of spinning.
+    struct pollfd watched[2] = {{timerFD, POLLIN, 0}, {pidFD, POLLIN, 0}};
+    if (poll(watched, child != -1 ? 2 : 1, -1) == -1)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      fprintf(stderr, "yash: watch: %s \n", strerror(errno));
+      status = 1;
+      break;
+    }
+
+    if (child != -1 && (watched[1].revents & POLLIN))
+    {
+      yash_finishWatchedRun("watch", child, pidFD);
+      child = -1;
+
+      // if the run took longer than the interval the timer has already fired
+      // and the next run starts right away.
+      timerfd_settime(timerFD, TFD_TIMER_ABSTIME, &timer, NULL);
+    }
+
+    if (watched[0].revents & POLLIN)
+    {
+      uint64_t expirations;
+      if (read(timerFD, &expirations, sizeof(expirations)) < 0 || child != -1)
+      {
+        continue;
+      }
+
+      yash_printWatchHeader(interval, commandText);
+      child = yash_startWatchedRun(ast, node, &pidFD);
+      if (child == -1)
+      {
+        status = 1;
+        break;
+      }
+
+      nextRun += intervalNanos;
+      if (nextRun < yash_monotonicNanos())
+      {
+        nextRun = yash_monotonicNanos();
+      }
+      timer.it_value.tv_sec = nextRun / 1000000000LL;
+      timer.it_value.tv_nsec = nextRun % 1000000000LL;
+      timerfd_settime(timerFD, TFD_TIMER_ABSTIME, &timer, NULL);
+    }
+  }
+
+  if (child != -1)
+  {
+    yash_stopWatchedRun(child, pidFD);
+  }
+  close(timerFD);
+  sigaction(SIGINT, &previousAction, NULL);
+  return status;
+}
+
+// this is the function used to add the inotify watches for the paths of onchange.
+// it is called again after each change as editors often replace a file by renaming
+// a new one over it, which removes the watch of the old file.
+int yash_addChangeWatches(int inotifyFD, char **paths, int pathCount)
+{
+  int watchCount = 0;
+  for (int path = 0; path < pathCount; path++)
+  {
+    if (inotify_add_watch(inotifyFD, paths[path], ONCHANGE_EVENTS) >= 0)
+    {
+      watchCount++;
+    }
+  }
+  return watchCount;
+}
+
+// this is the onchange builtin: onchange [-d MILLISECONDS] PATHS -- command
+// it runs the command once and then again each time inotify reports a change in one
+// of the paths. Changes are coalesced with a debounce window, the command runs when no
+// new change came for the window. If a run is still going when the next one is due
+// the stale run is stopped by killing its process group.
+// args are the words of the builtin before --, the command is the node of the tree.
+int yash_onChange(char **args, int argc, const yash_ast *ast, uint32_t node)
+{
+  int firstPath = 1;
+  int isValid = 1;
+  int64_t debounceNanos = ONCHANGE_DEBOUNCE_NANOS;
+  if (argc > 2 && strcmp(args[1], "-d") == 0)
+  {
+    char *end;
+    long milliseconds = strtol(args[2], &end, 10);
+    isValid = end != args[2] && *end == '\0' && milliseconds >= 0;
+    debounceNanos = milliseconds * 1000000LL;
+    firstPath = 3;
+  }
+  int pathCount = argc - firstPath;
+  if (!isValid || pathCount < 1)
+  {
+    yash_logMessage("Error: onchange: usage is onchange [-d MILLISECONDS] PATHS -- command");
+    return 2;
+  }
+  char **paths = args + firstPath;
+
+  int inotifyFD = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+  int debounceFD = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+  if (inotifyFD < 0 || debounceFD < 0 || yash_addChangeWatches(inotifyFD, paths, pathCount) == 0)
+  {
+    yash_logMessage("Error: onchange: could not watch the paths, check if they exist.");
+    if (inotifyFD >= 0)
+    {
+      close(inotifyFD);
+    }
+    if (debounceFD >= 0)
+    {
+      close(debounceFD);
+    }
+    return 1;
+  }
+
+  struct sigaction previousAction;
+  yash_beginWatching(&previousAction);
+
+  int pidFD = -1;
+  // the command is run again after each run which finished, but if a run can not be
+  // started onchange stops like watch does.
+  pid_t child = yash_startWatchedRun(ast, node, &pidFD);
+  int status = child == -1 ? 1 : 0;
+
+  while (!isWatchInterrupted && status == 0)
+  {
+    struct pollfd watched[3] = {{inotifyFD, POLLIN, 0}, {debounceFD, POLLIN, 0}, {pidFD, POLLIN, 0}};
+    if (poll(watched, child != -1 ? 3 : 2, -1) == -1)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      fprintf(stderr, "yash: onchange: %s \n", strerror(errno));
+      status = 1;
+      break;
+    }
+
+    if (child != -1 && (watched[2].revents & POLLIN))
+    {
+      yash_finishWatchedRun("onchange", child, pidFD);
+      child = -1;
+    }
+
+    // the events are only drained here, each one moves the end of the debounce window.
+    if (watched[0].revents & POLLIN)
+    {
+      char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+      int hasEvents = 0;
+      while (read(inotifyFD, events, sizeof(events)) > 0)
+      {
+        hasEvents = 1;
+      }
+
+      if (hasEvents)
+      {
+        struct itimerspec window = {{0, 0}, {debounceNanos / 1000000000LL, debounceNanos % 1000000000LL}};
+        if (debounceNanos == 0)
+        {
+          window.it_value.tv_nsec = 1;
+        }
+        timerfd_settime(debounceFD, 0, &window, NULL);
+      }
+    }
+
+    if (watched[1].revents & POLLIN)
+    {
+      uint64_t expirations;
+      if (read(debounceFD, &expirations, sizeof(expirations)) < 0)
+      {
+        continue;
+      }
+
+      if (child != -1)
+      {
+        fprintf(stderr, "yash: onchange: change detected, stopping the stale run \n");
+        yash_stopWatchedRun(child, pidFD);
+      }
+      yash_addChangeWatches(inotifyFD, paths, pathCount);
+      child = yash_startWatchedRun(ast, node, &pidFD);
+      if (child == -1)
+      {
+        status = 1;
+        break;
+      }
+    }
+  }
+
+  if (child != -1)
+  {
+    yash_stopWatchedRun(child, pidFD);
+  }
+  close(inotifyFD);
+  close(debounceFD);
+  sigaction(SIGINT, &previousAction, NULL);
+  return status;
+}
+
+// this is the function used to do the cleanup task by freeing memory
+void yash_cleanUp()
+{
+  free(userPrompt);
+}
+
+// this is the function used to hash the name of a variable with FNV-1a.
+uint64_t yash_hashName(const char *name)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  for (; *name != '\0'; name++)
+  {
+    hash = (hash ^ (unsigned char)*name) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+// this is the function used to find a variable in the hash table. A variable which is
+// not set in the shell but is in the environment is added as an exported variable.
+// if create is set a missing variable is added, otherwise it returns NULL.
+yash_variable *yash_findVariable(const char *name, int create)
+{
+  if (variableCapacity > 0)
+  {
+    for (size_t slot = yash_hashName(name) & (variableCapacity - 1);; slot = (slot + 1) & (variableCapacity - 1))
+    {
+      if (variables[slot].name == NULL)
+      {
+        break;
+      }
+      if (strcmp(variables[slot].name, name) == 0)
+      {
+        return &variables[slot];
+      }
+    }
+  }
+
+  const char *environmentValue = getenv(name);
+  if (!create && environmentValue == NULL)
+  {
+    return NULL;
+  }
+
+  // the table is kept at most half full so the probes stay short.
+  if ((variableCount + 1) * 2 > variableCapacity)
+  {
+    size_t oldCapacity = variableCapacity;
+    yash_variable *oldVariables = variables;
+    variableCapacity = oldCapacity == 0 ? 64 : oldCapacity * 2;
+    variables = calloc(variableCapacity, sizeof(yash_variable));
+    for (size_t index = 0; index < oldCapacity; index++)
+    {
+      if (oldVariables[index].name != NULL)
+      {
+        size_t slot = yash_hashName(oldVariables[index].name) & (variableCapacity - 1);
+        while (variables[slot].name != NULL)
+        {
+          slot = (slot + 1) & (variableCapacity - 1);
+        }
+        variables[slot] = oldVariables[index];
+      }
+    }
+    free(oldVariables);
+  }
+
+  size_t slot = yash_hashName(name) & (variableCapacity - 1);
+  while (variables[slot].name != NULL)
+  {
+    slot = (slot + 1) & (variableCapacity - 1);
+  }
+  yash_variable *variable = &variables[slot];
+  variable->name = strdup(name);
+  variable->value = environmentValue != NULL ? strdup(environmentValue) : NULL;
+  variable->isExported = environmentValue != NULL;
+  variableCount++;
+  return variable;
+}
+
+// this is the function used to make the text of a variable which only has its number.
+const char *yash_variableText(yash_variable *variable)
+{
+  if (variable->value == NULL && variable->hasNumber)
+  {
+    char number[24];
+    snprintf(number, sizeof(number), "%lld", (long long)variable->number);
+    variable->value = strdup(number);
+  }
+  return variable->value != NULL ? variable->value : "";
+}
+
+// this is the function used to get the text of a variable, an unset variable is empty.
+const char *yash_getVariableText(const char *name)
+{
+  yash_variable *variable = yash_findVariable(name, 0);
+  return variable != NULL ? yash_variableText(variable) : "";
+}
+
+// this is the function used to set a variable to a text.
+void yash_setVariableText(const char *name, const char *text)
+{
+  yash_variable *variable = yash_findVariable(name, 1);
+  char *value = strdup(text);
+  free(variable->value);
+  variable->value = value;
+  variable->hasNumber = 0;
+  if (variable->isExported)
+  {
+    setenv(name, value, 1);
+  }
+}
+
+// this is the function used to set a variable to a number, the text is made
+// only when the variable is expanded or exported.
+void yash_setVariableNumber(const char *name, int64_t number)
+{
+  yash_variable *variable = yash_findVariable(name, 1);
+  free(variable->value);
+  variable->value = NULL;
+  variable->number = number;
+  variable->hasNumber = 1;
+  if (variable->isExported)
+  {
+    setenv(name, yash_variableText(variable), 1);
+  }
+}
+
+// this is the function used to get the number of a variable for arithmetic, an unset
+// or empty variable is 0. The number is kept so the text is parsed only once.
+int64_t yash_getVariableNumber(const char *name, int *hasError)
+{
+  yash_variable *variable = yash_findVariable(name, 0);
+  if (variable == NULL || variable->hasNumber)
+  {
+    return variable != NULL ? variable->number : 0;
+  }
+
+  const char *text = yash_variableText(variable);
+  char *end;
+  errno = 0;
+  int64_t number = strtoll(text, &end, 0);
+  while (isspace((unsigned char)*end))
+  {
+    end++;
+  }
+  if (*end != '\0' || errno != 0)
+  {
+    fprintf(stderr, "yash: %s: value is not a number \n", name);
+    *hasError = 1;
+    return 0;
+  }
+  variable->number = number;
+  variable->hasNumber = 1;
+  return number;
+}
+
+// this is the function used to apply a binary arithmetic operator. The numbers wrap
+// around on overflow and the shift count is taken modulo 64 like the other shells do.
+int64_t yash_applyArithOperator(int operator, int64_t left, int64_t right, int *hasError)
+{
+  switch (operator)
+  {
+  case ARITH_OR:
+    return left || right;
+  case ARITH_AND:
+    return left && right;
+  case ARITH_BIT_OR:
+    return left | right;
+  case ARITH_BIT_XOR:
+    return left ^ right;
+  case ARITH_BIT_AND:
+    return left & right;
+  case ARITH_EQUAL:
+    return left == right;
+  case ARITH_NOT_EQUAL:
+    return left != right;
+  case ARITH_LESS_EQUAL:
+    return left <= right;
+  case ARITH_GREAT_EQUAL:
+    return left >= right;
+  case ARITH_SHIFT_LEFT:
+    return (int64_t)((uint64_t)left << (right & 63));
+  case ARITH_SHIFT_RIGHT:
+    return left >> (right & 63);
+  case ARITH_LESS:
+    return left < right;
+  case ARITH_GREAT:
+    return left > right;
+  case ARITH_ADD:
+    return (int64_t)((uint64_t)left + (uint64_t)right);
+  case ARITH_SUBTRACT:
+    return (int64_t)((uint64_t)left - (uint64_t)right);
+  case ARITH_MULTIPLY:
+    return (int64_t)((uint64_t)left * (uint64_t)right);
+  }
+
+  // the only division which overflows is the smallest number by -1.
+  if (right == 0)
+  {
+    fprintf(stderr, "yash: division by zero \n");
+    *hasError = 1;
+    return 0;
+  }
+  if (left == INT64_MIN && right == -1)
+  {
+    return operator == ARITH_DIVIDE ? INT64_MIN : 0;
+  }
+  return operator == ARITH_DIVIDE ? left / right : left % right;
+}
+
+// this is the function used to evaluate a compiled arithmetic expression,
+// hasError is set if a division by zero or a variable which is not a number is found.
+int64_t yash_evaluateArithmetic(const yash_ast *ast, uint32_t node, int *hasError)
+{
+  const yash_node *current = &ast->nodes[node];
+  const char *name = ast->strings + current->left;
+  int64_t value;
+
+  switch (current->type)
+  {
+  case NODE_ARITH_NUMBER:
+    return (int64_t)((uint64_t)current->right << 32 | current->left);
+  case NODE_STATUS:
+    return lastExitStatus;
+  case NODE_VARIABLE:
+    return yash_getVariableNumber(name, hasError);
+  case NODE_ARITH_UNARY:
+    value = yash_evaluateArithmetic(ast, current->left, hasError);
+    if (current->right == '-')
+    {
+      return (int64_t)(0 - (uint64_t)value);
+    }
+    return current->right == '!' ? !value : current->right == '~' ? ~value : value;
+  case NODE_ARITH_BINARY:
+    // && and || only evaluate the right side when it is needed.
+    value = yash_evaluateArithmetic(ast, current->left, hasError);
+    if (current->extra == ARITH_AND && !value)
+    {
+      return 0;
+    }
+    if (current->extra == ARITH_OR && value)
+    {
+      return 1;
+    }
+    int64_t right = yash_evaluateArithmetic(ast, current->right, hasError);
+    return *hasError ? 0 : yash_applyArithOperator(current->extra, value, right, hasError);
+  case NODE_ARITH_CONDITION:
+    value = yash_evaluateArithmetic(ast, current->left, hasError);
+    return yash_evaluateArithmetic(ast, value ? current->right : current->extra, hasError);
+  case NODE_ARITH_ASSIGN:
+    value = yash_evaluateArithmetic(ast, current->right, hasError);
+    if (!*hasError && current->extra != ARITH_ASSIGN)
+    {
+      value = yash_applyArithOperator(current->extra, yash_getVariableNumber(name, hasError), value, hasError);
+    }
+    if (*hasError)
+    {
+      return 0;
+    }
+    yash_setVariableNumber(name, value);
+    return value;
+  case NODE_ARITH_INCREMENT:
+    value = yash_getVariableNumber(name, hasError);
+    if (*hasError)
+    {
+      return 0;
+    }
+    int isIncrement = current->right == ARITH_PRE_INCREMENT || current->right == ARITH_POST_INCREMENT;
+    int64_t newValue = (int64_t)((uint64_t)value + (isIncrement ? 1 : (uint64_t)-1));
+    yash_setVariableNumber(name, newValue);
+    return current->right == ARITH_PRE_INCREMENT || current->right == ARITH_PRE_DECREMENT ? newValue : value;
+  }
+  return 0;
+}
+
+// this is the function used to expand a word of the tree into its text. A literal is
+// used from the string pool as it is, the other words are built and kept in the arguments
+// so they are freed with them. The text of a variable is copied as the variable can change
+// before the arguments are used, like in for i in $i. There is no field splitting, a
+// variable always expands to one argument. An error of an arithmetic expansion sets hasError.
+char *yash_expandWord(const yash_ast *ast, uint32_t word, yash_args *args)
+{
+  const yash_node *node = &ast->nodes[word];
+  if (node->type == NODE_LITERAL)
+  {
+    return ast->strings + node->left;
+  }
+
+  // the parts are written one after the other, a number is at most 20 characters.
+  size_t length = 0;
+  size_t capacity = 64;
+  char *text = malloc(capacity);
+  uint32_t first = node->type == NODE_WORD ? node->left : word;
+  uint32_t count = node->type == NODE_WORD ? node->right : 1;
+  for (uint32_t index = 0; index < count; index++)
+  {
+    const yash_node *part = &ast->nodes[node->type == NODE_WORD ? ast->lists[first + index] : word];
+    const char *partText = "";
+    char number[24];
+    if (part->type == NODE_LITERAL)
+    {
+      partText = ast->strings + part->left;
+    }
+    else if (part->type == NODE_STATUS)
+    {
+      snprintf(number, sizeof(number), "%d", lastExitStatus);
+      partText = number;
+    }
+    else if (part->type == NODE_VARIABLE)
+    {
+      partText = yash_getVariableText(ast->strings + part->left);
+    }
+    else if (part->type == NODE_ARITH)
+    {
+      int hasError = 0;
+      int64_t value = yash_evaluateArithmetic(ast, part->left, &hasError);
+      args->hasError |= hasError;
+      snprintf(number, sizeof(number), "%lld", (long long)value);
+      partText = number;
+    }
+
+    size_t partLength = strlen(partText);
+    if (length + partLength + 1 > capacity)
+    {
+      capacity = (length + partLength + 1) * 2;
+      text = realloc(text, capacity);
+    }
+    memcpy(text + length, partText, partLength);
+    length += partLength;
+  }
+  text[length] = '\0';
+
+  args->owned[args->ownedCount] = text;
+  args->ownedCount++;
+  return text;
+}
+
+// this is the function used to expand the words of a range of the lists into the
+// arguments of a command, the list of arguments is NULL terminated.
+void yash_expandArgs(const yash_ast *ast, uint32_t first, uint32_t count, yash_args *args)
+{
+  memset(args, 0, sizeof(*args));
+  args->argv = malloc(sizeof(char *) * (count + 1));
+  args->owned = malloc(sizeof(char *) * (count + 1));
+  args->argc = count;
+  for (uint32_t index = 0; index < count; index++)
+  {
+    args->argv[index] = yash_expandWord(ast, ast->lists[first + index], args);
+  }
+  args->argv[count] = NULL;
+}
+
+// this is the function used to free the expanded arguments.
+void yash_freeArgs(yash_args *args)
+{
+  for (int index = 0; index < args->ownedCount; index++)
+  {
+    free(args->owned[index]);
+  }
+  free(args->owned);
+  free(args->argv);
+  free(args->environment);
+  memset(args, 0, sizeof(*args));
+}
+
+// this is the function used to expand a simple command, the words after the assignments
+// are the arguments and the assignments are made NAME=value strings for the environment
+// of the command, like in CC=clang make.
+void yash_expandCommand(const yash_ast *ast, const yash_node *command, yash_args *args)
+{
+  uint32_t assignmentCount = command->extra;
+  yash_expandArgs(ast, command->left + assignmentCount, command->right - assignmentCount, args);
+  if (assignmentCount == 0)
+  {
+    return;
+  }
+
+  // each assignment can own its value and its NAME=value string.
+  args->owned = realloc(args->owned, sizeof(char *) * (args->argc + 2 * assignmentCount + 1));
+  args->environment = malloc(sizeof(char *) * assignmentCount);
+  for (uint32_t index = 0; index < assignmentCount; index++)
+  {
+    const yash_node *assignment = &ast->nodes[ast->lists[command->left + index]];
+    const char *name = ast->strings + assignment->left;
+    const char *value = yash_expandWord(ast, assignment->right, args);
+    size_t length = strlen(name) + strlen(value) + 2;
+    char *entry = malloc(length);
+    snprintf(entry, length, "%s=%s", name, value);
+    args->owned[args->ownedCount] = entry;
+    args->ownedCount++;
+    args->environment[args->environmentCount] = entry;
+    args->environmentCount++;
+  }
+}
+
+// this is the function used to record the assignments of a command in the audit log
+// like a command run by the shell, the arguments are NAME=value with the values given.
+void yash_auditAssignments(const yash_ast *ast, const yash_node *command, uint32_t count,
+                           int64_t startTime, int64_t duration, int status)
+{
+  char *words[count > 0 ? count : 1];
+  for (uint32_t index = 0; index < count; index++)
+  {
+    const char *name = ast->strings + ast->nodes[ast->lists[command->left + index]].left;
+    const char *value = yash_getVariableText(name);
+    size_t length = strlen(name) + strlen(value) + 2;
+    words[index] = malloc(length);
+    snprintf(words[index], length, "%s=%s", name, value);
+  }
+  yash_auditRecord(AUDIT_RECORD_COMMAND, AUDIT_FLAG_BUILTIN, words, count, startTime, duration, getpid(),
+                   (status & 0xff) << 8);
+  for (uint32_t index = 0; index < count; index++)
+  {
+    free(words[index]);
+  }
+}
+
+// this is the function used to run a command which only has assignments like i=$((i + 1)).
+// a value which is only an arithmetic expansion is stored as a number, so a counter
+// in a loop is never converted to text and back.
+int yash_assignVariables(const yash_ast *ast, const yash_node *command)
+{
+  int64_t startTime = isAuditEnabled ? yash_realtimeNanos() : 0;
+  int64_t startClock = isAuditEnabled ? yash_monotonicNanos() : 0;
+  int status = 0;
+  uint32_t index = 0;
+  for (; index < command->right; index++)
+  {
+    const yash_node *assignment = &ast->nodes[ast->lists[command->left + index]];
+    const char *name = ast->strings + assignment->left;
+    const yash_node *value = &ast->nodes[assignment->right];
+    if (value->type == NODE_ARITH)
+    {
+      int hasError = 0;
+      int64_t number = yash_evaluateArithmetic(ast, value->left, &hasError);
+      if (hasError)
+      {
+        status = 1;
+        break;
+      }
+      yash_setVariableNumber(name, number);
+      continue;
+    }
+
+    char *owned[1];
+    yash_args valueArgs;
+    memset(&valueArgs, 0, sizeof(valueArgs));
+    valueArgs.owned = owned;
+    const char *text = yash_expandWord(ast, assignment->right, &valueArgs);
+    if (!valueArgs.hasError)
+    {
+      yash_setVariableText(name, text);
+    }
+    if (valueArgs.ownedCount > 0)
+    {
+      free(owned[0]);
+    }
+    if (valueArgs.hasError)
+    {
+      status = 1;
+      break;
+    }
+  }
+
+  // the assignments done before an error are recorded.
+  if (isAuditEnabled)
+  {
+    yash_auditAssignments(ast, command, index, startTime, yash_monotonicNanos() - startClock, status);
+  }
+  return status;
+}
+
+// this is the function used to build the redirection plan of a node wrapped by
+// redirections, the targets are expanded in the order the redirections are written.
+// it returns the node which is redirected or NODE_NONE if a target is not valid.
+uint32_t yash_buildRedirectPlan(const yash_ast *ast, uint32_t node, yash_redirectPlan *plan)
+{
+  int count = 0;
+  uint32_t inner = node;
+  while (ast->nodes[inner].type == NODE_REDIRECT)
+  {
+    inner = ast->nodes[inner].left;
+    count++;
+  }
+
+  plan->redirects = malloc(sizeof(yash_redirect) * (count > 0 ? count : 1));
+  plan->count = count;
+  memset(&plan->words, 0, sizeof(plan->words));
+  plan->words.owned = malloc(sizeof(char *) * (count > 0 ? count : 1));
+
+  // the outer redirection was written last so the plan is filled from the end.
+  for (int index = count - 1; index >= 0; index--)
+  {
+    const yash_node *current = &ast->nodes[node];
+    yash_redirect *redirect = &plan->redirects[index];
+    redirect->type = current->right & 0xff;
+    redirect->fd = current->right >> 8;
+    redirect->targetFD = -1;
+    redirect->path = yash_expandWord(ast, current->extra, &plan->words);
+    node = current->left;
+
+    if (redirect->type == REDIRECT_DUPLICATE && strcmp(redirect->path, "-") == 0)
+    {
+      redirect->type = REDIRECT_CLOSE;
+    }
+    else if (redirect->type == REDIRECT_DUPLICATE)
+    {
+      char *end;
+      long targetFD = strtol(redirect->path, &end, 10);
+      if (end == redirect->path || *end != '\0' || targetFD < 0 || targetFD > REDIRECT_MAX_FD)
+      {
+        fprintf(stderr, "yash: %s: ambiguous redirect \n", redirect->path);
+        return NODE_NONE;
+      }
+      redirect->targetFD = targetFD;
+    }
+  }
+  return plan->words.hasError ? NODE_NONE : inner;
+}
+
+// this is the function used to free the redirection plan.
+void yash_freeRedirectPlan(yash_redirectPlan *plan)
+{
+  yash_freeArgs(&plan->words);
+  free(plan->redirects);
+  memset(plan, 0, sizeof(*plan));
+}
+
+// this is the fg builtin, the shell will start waiting for the latest bg process.
+// if there is no bg process it will print error message.
+int yash_foreground()
+{
+  if (bgProcessListPointer == -1)
+  {
+    yash_logMessage("No Background Process Exist.");
+    return 1;
+  }
+
+  isFgProcess = 1;
+  int status = 0;
+  yash_logMessage("Foreground Process: ");
+  yash_logMessage(bgProcessNames[bgProcessListPointer]);
+
+  // wait for lastest process executing in background.
+  while (waitpid(bgProcessIds[bgProcessListPointer], &status, 0) == -1 && errno == EINTR)
+  {
+  }
+
+  yash_auditBackgroundExit(bgProcessListPointer, status);
+  yash_freeBackgroundProcess(bgProcessListPointer);
+  bgProcessListPointer--;
+  isFgProcess = 0;
+  return yash_exitStatus(status);
+}
+
+// this is the wait builtin: wait [-f]
+// it waits for all the background processes and returns the first non zero exit status,
+// so { a & b & wait; } && c runs c only if both a and b succeeded. The processes are
+// waited with their pidfds in one poll so they are reaped in the order they finish.
+// with -f the other processes are stopped as soon as one fails.
+int yash_waitBuiltin(char **args, int argc)
+{
+  int isFailFast = argc > 1 && strcmp(args[1], "-f") == 0;
+  if (argc > 2 || (argc == 2 && !isFailFast))
+  {
+    yash_logMessage("Error: wait: usage is wait [-f]");
+    return 2;
+  }
+
+  int processCount = bgProcessListPointer + 1;
+  int pidFDs[MAX_BACKGROUND_PROCESSES];
+  int pending = 0;
+  int result = 0;
+  for (int index = 0; index < processCount; index++)
+  {
+    pidFDs[index] = syscall(SYS_pidfd_open, bgProcessIds[index], 0);
+    if (pidFDs[index] >= 0)
+    {
+      pending++;
+    }
+    else
+    {
+      // without a pidfd the process is waited after the others, this only happens on
+      // old kernels or if the process has already been reaped.
+      int status = 0;
+      if (waitpid(bgProcessIds[index], &status, 0) > 0)
+      {
+        yash_auditBackgroundExit(index, status);
+        result = result == 0 ? yash_exitStatus(status) : result;
+      }
+    }
+  }
+
+  while (pending > 0)
+  {
+    struct pollfd watched[MAX_BACKGROUND_PROCESSES];
+    int watchedProcesses[MAX_BACKGROUND_PROCESSES];
+    int watchedCount = 0;
+    for (int index = 0; index < processCount; index++)
+    {
+      if (pidFDs[index] >= 0)
+      {
+        watched[watchedCount] = (struct pollfd){pidFDs[index], POLLIN, 0};
+        watchedProcesses[watchedCount] = index;
+        watchedCount++;
+      }
+    }
+
+    if (poll(watched, watchedCount, -1) == -1)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      break;
+    }
+
+    for (int watchedIndex = 0; watchedIndex < watchedCount; watchedIndex++)
+    {
+      int index = watchedProcesses[watchedIndex];
+      if (!(watched[watchedIndex].revents & POLLIN))
+      {
+        continue;
+      }
+
+      int status = 0;
+      while (waitpid(bgProcessIds[index], &status, 0) == -1 && errno == EINTR)
+      {
+      }
+      close(pidFDs[index]);
+      pidFDs[index] = -1;
+      pending--;
+      yash_auditBackgroundExit(index, status);
+
+      if (yash_exitStatus(status) == 0 || result != 0)
+      {
+        continue;
+      }
+      result = yash_exitStatus(status);
+
+      // each background process is the leader of its own session
+      // so its whole group is stopped with it.
+      if (isFailFast && pending > 0)
+      {
+        fprintf(stderr, "yash: wait: %s failed with status %d, stopping the other processes \n",
+                bgProcessNames[index], result);
+        for (int other = 0; other < processCount; other++)
+        {
+          if (pidFDs[other] >= 0)
+          {
+            kill(-bgProcessIds[other], SIGTERM);
+            kill(-bgProcessIds[other], SIGCONT);
+          }
+        }
+      }
+    }
+  }
+
+  for (int index = 0; index < processCount; index++)
+  {
+    if (pidFDs[index] >= 0)
+    {
+      close(pidFDs[index]);
+    }
+    yash_freeBackgroundProcess(index);
+  }
+  bgProcessListPointer = -1;
+  return result;
+}
+
+// this is the function used to check a unary operator of test like -f file.
+int yash_testUnary(const char *operator, const char *operand)
+{
+  struct stat fileInfo;
+  if (strcmp(operator, "-n") == 0)
+  {
+    return operand[0] != '\0';
+  }
+  if (strcmp(operator, "-z") == 0)
+  {
+    return operand[0] == '\0';
+  }
+  if (strcmp(operator, "-L") == 0 || strcmp(operator, "-h") == 0)
+  {
+    return lstat(operand, &fileInfo) == 0 && S_ISLNK(fileInfo.st_mode);
+  }
+  if (strcmp(operator, "-r") == 0 || strcmp(operator, "-w") == 0 || strcmp(operator, "-x") == 0)
+  {
+    int mode = operator[1] == 'r' ? R_OK : operator[1] == 'w' ? W_OK : X_OK;
+    return access(operand, mode) == 0;
+  }
+
+  int exists = stat(operand, &fileInfo) == 0;
+  if (strcmp(operator, "-f") == 0)
+  {
+    return exists && S_ISREG(fileInfo.st_mode);
+  }
+  if (strcmp(operator, "-d") == 0)
+  {
+    return exists && S_ISDIR(fileInfo.st_mode);
+  }
+  if (strcmp(operator, "-s") == 0)
+  {
+    return exists && fileInfo.st_size > 0;
+  }
+  return exists;
+}
+
+// this is the function used to check if the word is a unary operator of test.
+int yash_isTestUnary(const char *word)
+{
+  static const char *operators[] = {"-n", "-z", "-e", "-f", "-d", "-r", "-w", "-x", "-s", "-L", "-h"};
+  for (size_t index = 0; index < sizeof(operators) / sizeof(operators[0]); index++)
+  {
+    if (strcmp(word, operators[index]) == 0)
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// this is the function used to compare two numbers of test like 1 -lt 2,
+// it returns -1 if the operator is not one of them or a side is not a number.
+int yash_testNumbers(const char *left, const char *operator, const char *right)
+{
+  static const char *operators[] = {"-eq", "-ne", "-lt", "-le", "-gt", "-ge"};
+  int operatorIndex = -1;
+  for (int index = 0; index < 6; index++)
+  {
+    if (strcmp(operator, operators[index]) == 0)
+    {
+      operatorIndex = index;
+    }
+  }
+  if (operatorIndex == -1)
+  {
+    return -1;
+  }
+
+  char *leftEnd;
+  char *rightEnd;
+  errno = 0;
+  long long leftNumber = strtoll(left, &leftEnd, 10);
+  long long rightNumber = strtoll(right, &rightEnd, 10);
+  if (leftEnd == left || *leftEnd != '\0' || rightEnd == right || *rightEnd != '\0' || errno != 0)
+  {
+    return -1;
+  }
+
+  switch (operatorIndex)
+  {
+  case 0:
+    return leftNumber == rightNumber;
+  case 1:
+    return leftNumber != rightNumber;
+  case 2:
+    return leftNumber < rightNumber;
+  case 3:
+    return leftNumber <= rightNumber;
+  case 4:
+    return leftNumber > rightNumber;
+  }
+  return leftNumber >= rightNumber;
+}
+
+int yash_testOr(char **args, int argc, int *position);
+
+// this is the function used to evaluate a primary of test: ( expression ), ! primary,
+// a unary or a binary operator or a single word which is true if it is not empty.
+// it returns 1 for true, 0 for false and -1 on error.
+int yash_testPrimary(char **args, int argc, int *position)
+{
+  if (*position >= argc)
+  {
+    return -1;
+  }
+  const char *word = args[*position];
+
+  if (strcmp(word, "!") == 0)
+  {
+    (*position)++;
+    int result = yash_testPrimary(args, argc, position);
+    return result == -1 ? -1 : !result;
+  }
+  if (strcmp(word, "(") == 0)
+  {
+    (*position)++;
+    int result = yash_testOr(args, argc, position);
+    if (result == -1 || *position >= argc || strcmp(args[*position], ")") != 0)
+    {
+      return -1;
+    }
+    (*position)++;
+    return result;
+  }
+
+  // a word followed by a binary operator is a comparison.
+  if (*position + 2 < argc)
+  {
+    const char *operator = args[*position + 1];
+    int isString = strcmp(operator, "=") == 0 || strcmp(operator, "==") == 0 || strcmp(operator, "!=") == 0;
+    if (isString || (operator[0] == '-' && strlen(operator) == 3))
+    {
+      const char *right = args[*position + 2];
+      *position += 3;
+      if (isString)
+      {
+        return (strcmp(word, right) == 0) == (operator[0] == '=');
+      }
+      return yash_testNumbers(word, operator, right);
+    }
+  }
+
+  if (yash_isTestUnary(word) && *position + 1 < argc)
+  {
+    *position += 2;
+    return yash_testUnary(word, args[*position - 1]);
+  }
+  (*position)++;
+  return word[0] != '\0';
+}
+
+// this is the function used to evaluate the primaries joined by -a.
+int yash_testAnd(char **args, int argc, int *position)
+{
+  int result = yash_testPrimary(args, argc, position);
+  while (result != -1 && *position < argc && strcmp(args[*position], "-a") == 0)
+  {
+    (*position)++;
+    int right = yash_testPrimary(args, argc, position);
+    result = right == -1 ? -1 : result && right;
+  }
+  return result;
+}
+
+// this is the function used to evaluate the expressions joined by -o,
+// -a is done before -o like in the other shells.
+int yash_testOr(char **args, int argc, int *position)
+{
+  int result = yash_testAnd(args, argc, position);
+  while (result != -1 && *position < argc && strcmp(args[*position], "-o") == 0)
+  {
+    (*position)++;
+    int right = yash_testAnd(args, argc, position);
+    result = right == -1 ? -1 : result || right;
+  }
+  return result;
+}
+
+// this is the test builtin, also used as [ expression ].
+// it returns 0 if the expression is true, 1 if it is false and 2 on error.
+int yash_testBuiltin(char **args, int argc)
+{
+  if (strcmp(args[0], "[") == 0)
+  {
+    if (strcmp(args[argc - 1], "]") != 0)
+    {
+      yash_logMessage("Error: [: missing ]");
+      return 2;
+    }
+    argc--;
+  }
+  if (argc == 1)
+  {
+    return 1;
+  }
+
+  int position = 1;
+  int result = yash_testOr(args, argc, &position);
+  if (result == -1 || position != argc)
+  {
+    fprintf(stderr, "yash: %s: invalid expression \n", args[0]);
+    return 2;
+  }
+  return !result;
+}
+
+// this is the function used by break and continue to read how many loops they leave,
+// it returns 0 if the number is not valid or the builtin is not in a loop.
+int yash_loopLevels(char **args, int argc)
+{
+  if (loopDepth == 0)
+  {
+    fprintf(stderr, "yash: %s: only meaningful in a loop \n", args[0]);
+    return 0;
+  }
+
+  long levels = 1;
+  if (argc > 1)
+  {
+    char *end;
+    levels = strtol(args[1], &end, 10);
+    if (argc > 2 || end == args[1] || *end != '\0' || levels < 1)
+    {
+      fprintf(stderr, "yash: %s: %s: loop count out of range \n", args[0], args[1]);
+      return 0;
+    }
+  }
+  return levels > loopDepth ? loopDepth : levels;
+}
+
+// this is the break builtin: break [n], it leaves n loops.
+int yash_breakBuiltin(char **args, int argc)
+{
+  breakLevels = yash_loopLevels(args, argc);
+  return breakLevels == 0;
+}
+
+// this is the continue builtin: continue [n], it leaves n - 1 loops
+// and continues with the next iteration of the last one.
+int yash_continueBuiltin(char **args, int argc)
+{
+  continueLevels = yash_loopLevels(args, argc);
+  return continueLevels == 0;
+}
+
+// this is the export builtin: export NAME[=value]...
+// the variables are put in the environment so the commands started later get them.
+int yash_exportBuiltin(char **args, int argc)
+{
+  int status = 0;
+  for (int index = 1; index < argc; index++)
+  {
+    char *equal = strchr(args[index], '=');
+    size_t nameLength = equal != NULL ? (size_t)(equal - args[index]) : strlen(args[index]);
+    if (nameLength == 0 || yash_nameLength(args[index], nameLength) != nameLength)
+    {
+      fprintf(stderr, "yash: export: %s: not a valid name \n", args[index]);
+      status = 1;
+      continue;
+    }
+
+    char name[nameLength + 1];
+    memcpy(name, args[index], nameLength);
+    name[nameLength] = '\0';
+    yash_variable *variable = yash_findVariable(name, 1);
+    variable->isExported = 1;
+    if (equal != NULL)
+    {
+      yash_setVariableText(name, equal + 1);
+    }
+    else
+    {
+      setenv(name, yash_variableText(variable), 1);
+    }
+  }
+  return status;
+}
+
+// this is the newt builtin which opens a new terminal session.
+int yash_newtBuiltin(char **args, int argc)
+{
+  (void)args;
+  (void)argc;
+  return yash_openNewSession();
+}
+
+// this is the fg builtin which waits for the latest bg process.
+int yash_fgBuiltin(char **args, int argc)
+{
+  (void)args;
+  (void)argc;
+  return yash_foreground();
+}
+
+// these are the true, false and : builtins.
+int yash_trueBuiltin(char **args, int argc)
+{
+  (void)args;
+  (void)argc;
+  return 0;
+}
+
+int yash_falseBuiltin(char **args, int argc)
+{
+  (void)args;
+  (void)argc;
+  return 1;
+}
+
+// this is the table of the builtins which run in the shell itself and not in a child.
+const yash_builtin yash_builtins[] = {
+    {"newt", yash_newtBuiltin},
+    {"fg", yash_fgBuiltin},
+    {"wait", yash_waitBuiltin},
+    {"test", yash_testBuiltin},
+    {"[", yash_testBuiltin},
+    {"true", yash_trueBuiltin},
+    {"false", yash_falseBuiltin},
+    {":", yash_trueBuiltin},
+    {"break", yash_breakBuiltin},
+    {"continue", yash_continueBuiltin},
+    {"export", yash_exportBuiltin},
+};
+
+// this is the function used to find a builtin in the table, it returns NULL if there is none.
+const yash_builtin *yash_findBuiltin(const char *command)
+{
+  for (size_t index = 0; index < sizeof(yash_builtins) / sizeof(yash_builtins[0]); index++)
+  {
+    if (strcmp(command, yash_builtins[index].name) == 0)
+    {
+      return &yash_builtins[index];
+    }
+  }
+  return NULL;
+}
+
+// this is the function used to run the builtins which are simple commands,
+// it returns -1 if the command is not a builtin.
+int yash_runBuiltin(char **args, int argc)
+{
+  const yash_builtin *builtin = yash_findBuiltin(args[0]);
+  if (builtin == NULL)
+  {
+    return -1;
+  }
+
+  // a builtin is recorded in the audit log like the commands, with the pid of the shell.
+  int64_t startTime = isAuditEnabled ? yash_realtimeNanos() : 0;
+  int64_t startClock = isAuditEnabled ? yash_monotonicNanos() : 0;
+  int status = builtin->function(args, argc);
+  if (isAuditEnabled)
+  {
+    yash_auditRecord(AUDIT_RECORD_COMMAND, AUDIT_FLAG_BUILTIN, args, argc, startTime,
+                     yash_monotonicNanos() - startClock, getpid(), (status & 0xff) << 8);
+  }
+  return status;
+}
+
+// this is the function used to check if a simple command is a builtin
+// which has to run in the shell itself and not in a child.
+int yash_isBuiltin(const char *command)
+{
+  return yash_findBuiltin(command) != NULL;
+}
+
+// this is the relay thread of the profile builtin, it moves the data from the pipe of
+// a stage to the pipe of the next stage with splice so the data is never copied to the
+// shell. When splice can not move anything the relay checks which side is blocking and
+// adds the time it waits to the empty time (the stage before is too slow) or to the
+// full time (the stage after is too slow).
+void *yash_relayPipe(void *argument)
+{
+  yash_pipeRelay *relay = argument;
+  while (1)
+  {
+    ssize_t moved = splice(relay->inFD, NULL, relay->outFD, NULL, PROFILE_SPLICE_SIZE,
+                           SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (moved > 0)
+    {
+      atomic_fetch_add_explicit(&relay->bytes, moved, memory_order_relaxed);
+      continue;
+    }
+    if (moved == -1 && errno == EINTR)
+    {
+      continue;
+    }
+
+    // the stage before has closed its output or the stage after has exited.
+    if (moved == 0 || errno != EAGAIN)
+    {
+      break;
+    }
+
+    struct pollfd waited[2] = {{relay->inFD, POLLIN, 0}, {relay->stopFD, POLLIN, 0}};
+    int isEmpty = poll(waited, 1, 0) == 0;
+    if (!isEmpty)
+    {
+      waited[0] = (struct pollfd){relay->outFD, POLLOUT, 0};
+    }
+    int64_t waitStart = yash_monotonicNanos();
+    while (poll(waited, 2, -1) == -1 && errno == EINTR)
+    {
+    }
+    atomic_fetch_add_explicit(isEmpty ? &relay->emptyNanos : &relay->fullNanos,
+                              yash_monotonicNanos() - waitStart, memory_order_relaxed);
+    if (waited[1].revents & POLLIN)
+    {
+      break;
+    }
+  }
+
+  // closing the ends gives the stage after its end of input and the stage before SIGPIPE.
+  close(relay->inFD);
+  close(relay->outFD);
+  atomic_store_explicit(&relay->endClock, yash_monotonicNanos(), memory_order_release);
+  return NULL;
+}
+
+// this is the handler of SIGUSR1 while a pipeline is profiled, the report is printed by
+// the reporter thread as printf can not be used in a signal handler.
+void yash_handleProfileSignal(int signalNumber)
+{
+  (void)signalNumber;
+  uint64_t one = 1;
+  if (write(profileSignalFD, &one, sizeof(one)) < 0)
+  {
+    return;
+  }
+}
+
+// this is the function used to write a number of bytes in a short form like 12.5 MB.
+void yash_formatBytes(char *text, size_t size, double bytes)
+{
+  const char *units[] = {"B", "KB", "MB", "GB", "TB"};
+  int unit = 0;
+  while (bytes >= 1024 && unit < 4)
+  {
+    bytes /= 1024;
+    unit++;
+  }
+  snprintf(text, size, unit == 0 ? "%.0f %s" : "%.1f %s", bytes, units[unit]);
+}
+
+// this is the function used to print the report of a profiled pipeline. For each stage
+// it prints the data it read and wrote, its output rate, the part of the time it was
+// starved (its input pipe was empty) and blocked (its output pipe was full). The stage
+// which is the least starved and blocked is the bottleneck of the pipeline.
+void yash_printProfileReport(const yash_profile *profile, int isFinal)
+{
+  int64_t now = yash_monotonicNanos();
+  double elapsed = (now - profile->startClock) / 1e9;
+  fprintf(stderr, "yash: profile: %d stage%s, %.3f s%s \n", profile->stageCount,
+          profile->stageCount == 1 ? "" : "s", elapsed,
+          isFinal ? "" : " (running)");
+  fprintf(stderr, "  %-5s %-24s %10s %10s %12s %8s %8s \n", "stage", "command", "in", "out", "out rate",
+          "starved", "blocked");
+
+  int bottleneck = -1;
+  double bottleneckBusy = -1;
+  for (int stage = 0; stage < profile->stageCount; stage++)
+  {
+    char in[16] = "-";
+    char out[16] = "-";
+    char rate[24] = "-";
+    char starved[16] = "-";
+    char blocked[16] = "-";
+    double busy = 100;
+
+    // the relay before the stage is its input and the one after is its output.
+    for (int side = 0; side < 2; side++)
+    {
+      int relayIndex = stage - 1 + side;
+      if (relayIndex < 0 || relayIndex >= profile->relayCount)
+      {
+        continue;
+      }
+      const yash_pipeRelay *relay = &profile->relays[relayIndex];
+      int64_t endClock = atomic_load_explicit(&relay->endClock, memory_order_acquire);
+      double relayElapsed = ((endClock != 0 ? endClock : now) - profile->startClock) / 1e9;
+      double bytes = atomic_load_explicit(&relay->bytes, memory_order_relaxed);
+      int64_t waited = atomic_load_explicit(side == 0 ? &relay->emptyNanos : &relay->fullNanos,
+                                            memory_order_relaxed);
+      double percent = relayElapsed > 0 ? 100 * waited / 1e9 / relayElapsed : 0;
+      busy -= percent;
+
+      if (side == 0)
+      {
+        yash_formatBytes(in, sizeof(in), bytes);
+        snprintf(starved, sizeof(starved), "%.1f%%", percent);
+      }
+      else
+      {
+        yash_formatBytes(out, sizeof(out), bytes);
+        yash_formatBytes(rate, sizeof(rate) - 2, relayElapsed > 0 ? bytes / relayElapsed : 0);
+        strcat(rate, "/s");
+        snprintf(blocked, sizeof(blocked), "%.1f%%", percent);
+      }
+    }
+
+    fprintf(stderr, "  %-5d %-24s %10s %10s %12s %8s %8s \n", stage + 1, profile->stageNames[stage], in, out,
+            rate, starved, blocked);
+    if (busy > bottleneckBusy)
+    {
+      bottleneck = stage;
+      bottleneckBusy = busy;
+    }
+  }
+
+  if (profile->relayCount > 0)
+  {
+    fprintf(stderr, "  bottleneck: stage %d (%s) \n", bottleneck + 1, profile->stageNames[bottleneck]);
+  }
+}
+
+// this is the reporter thread of the profile builtin, it prints the report each time
+// SIGUSR1 is received until the pipeline is finished.
+void *yash_profileReporter(void *argument)
+{
+  yash_profile *profile = argument;
+  struct pollfd waited[2] = {{profileSignalFD, POLLIN, 0}, {profile->stopFD, POLLIN, 0}};
+  while (1)
+  {
+    if (poll(waited, 2, -1) == -1 && errno != EINTR)
+    {
+      break;
+    }
+    if (waited[1].revents & POLLIN)
+    {
+      break;
+    }
+    if (waited[0].revents & POLLIN)
+    {
+      uint64_t signals;
+      if (read(profileSignalFD, &signals, sizeof(signals)) > 0)
+      {
+        yash_printProfileReport(profile, 0);
+      }
+    }
+  }
+  return NULL;
+}
+
+// this is the function used in a copy of the shell started for a stage of a profiled
+// pipeline, the ends of the relays of the other stages are closed so the pipes get
+// their end of input when the stages are done.
+void yash_closeProfileRelays()
+{
+  if (activeProfile == NULL)
+  {
+    return;
+  }
+  for (int index = 0; index < activeProfile->relayCount; index++)
+  {
+    close(activeProfile->relays[index].inFD);
+    close(activeProfile->relays[index].outFD);
+  }
+  activeProfile = NULL;
+}
+
+// this is the function used to start the relay threads and the reporter thread of a
+// profiled pipeline once all its stages are started. The threads do not get the signals
+// of the shell, SIGPIPE of a relay becomes EPIPE from splice.
+void yash_startProfile(yash_profile *profile)
+{
+  profile->stopFD = eventfd(0, EFD_CLOEXEC);
+  profileSignalFD = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+  sigset_t allSignals, previousSignals;
+  sigfillset(&allSignals);
+  pthread_sigmask(SIG_BLOCK, &allSignals, &previousSignals);
+  for (int index = 0; index < profile->relayCount; index++)
+  {
+    yash_pipeRelay *relay = &profile->relays[index];
+    relay->stopFD = profile->stopFD;
+    relay->hasThread = pthread_create(&relay->thread, NULL, yash_relayPipe, relay) == 0;
+    if (!relay->hasThread)
+    {
+      yash_logMessage("Error: profile: Could not start the relay of a pipe.");
+      close(relay->inFD);
+      close(relay->outFD);
+    }
+  }
+  profile->hasReporter = pthread_create(&profile->reporter, NULL, yash_profileReporter, profile) == 0;
+  pthread_sigmask(SIG_SETMASK, &previousSignals, NULL);
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = yash_handleProfileSignal;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_RESTART;
+  sigaction(SIGUSR1, &action, &profile->previousAction);
+}
+
+// this is the function used to stop the threads of a profiled pipeline after all its
+// stages are waited and print the final report.
+void yash_finishProfile(yash_profile *profile)
+{
+  sigaction(SIGUSR1, &profile->previousAction, NULL);
+
+  uint64_t one = 1;
+  if (write(profile->stopFD, &one, sizeof(one)) < 0)
+  {
+    yash_logMessage("Error: profile: Could not stop the relays.");
+  }
+  for (int index = 0; index < profile->relayCount; index++)
+  {
+    if (profile->relays[index].hasThread)
+    {
+      pthread_join(profile->relays[index].thread, NULL);
+    }
+  }
+  if (profile->hasReporter)
+  {
+    pthread_join(profile->reporter, NULL);
+  }
+  close(profile->stopFD);
+  close(profileSignalFD);
+  profileSignalFD = -1;
+  activeProfile = NULL;
+
+  yash_printProfileReport(profile, 1);
+}
+
+// this is the function used to run a part of the tree in a forked copy of the shell,
+// for subshells, redirected groups and for the parts of a pipeline which are not simple
+// commands. The stdio buffers are flushed before so they are not written twice.
+pid_t yash_forkShell(const yash_ast *ast, uint32_t node, int inFD, int outFD, int closeFD,
+                     const yash_redirectPlan *plan)
+{
+  fflush(NULL);
+  pid_t child = fork();
+  if (child == -1)
+  {
+    yash_logMessage("Error while creating child to execute a command.");
+    return -1;
+  }
+
+  if (child == 0)
+  {
+    // a stage of a pipeline with a deadline joins the group of the pipeline,
+    // the commands it starts itself are not stages of that pipeline.
+    if (pipelineGroup != -1)
+    {
+      setpgid(0, pipelineGroup);
+      pipelineGroup = -1;
+    }
+    if (inFD != -1)
+    {
+      dup2(inFD, STDIN_FILENO);
+      close(inFD);
+    }
+    if (outFD != -1)
+    {
+      dup2(outFD, STDOUT_FILENO);
+      close(outFD);
+    }
+    if (closeFD != -1)
+    {
+      close(closeFD);
+    }
+    yash_applyRedirectPlan(plan);
+    yash_closeProfileRelays();
+    signal(SIGINT, SIG_DFL);
+    yash_auditAfterFork();
+
+    // the background processes of the shell are not children of this copy.
+    bgProcessListPointer = -1;
+    int status = yash_executeNode(ast, node);
+    fflush(NULL);
+    _exit(status);
+  }
+
+  if (pipelineGroup != -1)
+  {
+    pipelineGroup = pipelineGroup == 0 ? child : pipelineGroup;
+    setpgid(child, pipelineGroup);
+  }
+  return child;
+}
+
+// this is the function used to execute a simple command, a command with only
+// assignments sets the variables of the shell.
+// the deadline of @deadline= only lasts for one pipeline so it is reset here.
+int yash_executeSimpleCommand(const yash_ast *ast, const yash_node *node)
+{
+  if (node->extra == node->right)
+  {
+    return yash_assignVariables(ast, node);
+  }
+
+  yash_args args;
+  yash_expandCommand(ast, node, &args);
+  pipelineDeadline = 0;
+
+  int status = 1;
+  if (!args.hasError)
+  {
+    status = yash_runBuiltin(args.argv, args.argc);
+  }
+  if (status == -1)
+  {
+    status = yash_executeCommand(&args, NULL);
+  }
+  yash_freeArgs(&args);
+  return status;
+}
+
+// this is the function used to execute a pipeline. All the stages are started at once
+// connected with pipes and then waited together, so a slow stage does not hold the
+// others back. The pipes are made with O_CLOEXEC and are moved to stdin and stdout only
+// in the children, the shell never changes its own stdin and stdout.
+// the exit status of the pipeline is the status of the last stage.
+// a profiled pipeline has a relay between each two stages which is made of a second
+// pipe, the relays are started once all the stages are started.
+// the words of all the stages are expanded first, if a stage has a deadline all the
+// stages are put in one process group which gets the terminal while it runs.
+int yash_executePipeline(const yash_ast *ast, const yash_node *node)
+{
+  uint32_t stageCount = node->right;
+  yash_child children[stageCount];
+  yash_args stageArgs[stageCount];
+  yash_redirectPlan plan;
+  int childCount = 0;
+  int status = 0;
+  int previousRead = -1;
+
+  yash_pipeRelay relays[stageCount];
+  char stageNames[stageCount][PROFILE_NAME_SIZE];
+  yash_profile profile;
+  int isProfiled = node->extra == 1;
+  if (isProfiled)
+  {
+    memset(&profile, 0, sizeof(profile));
+    memset(relays, 0, sizeof(relays));
+    profile.relays = relays;
+    profile.stageNames = stageNames;
+    profile.stageCount = stageCount;
+    profile.startClock = yash_monotonicNanos();
+    activeProfile = &profile;
+  }
+
+  pipelineDeadline = 0;
+  memset(stageArgs, 0, sizeof(stageArgs));
+
+  int hasDeadline = 0;
+  for (uint32_t stage = 0; stage < stageCount; stage++)
+  {
+    uint32_t inner = ast->lists[node->left + stage];
+    while (ast->nodes[inner].type == NODE_REDIRECT)
+    {
+      inner = ast->nodes[inner].left;
+    }
+    const yash_node *command = &ast->nodes[inner];
+    if (command->type == NODE_COMMAND && command->extra < command->right)
+    {
+      yash_expandCommand(ast, command, &stageArgs[stage]);
+      hasDeadline |= !stageArgs[stage].hasError && yash_hasDeadline(&stageArgs[stage]);
+    }
+  }
+  pipelineGroup = hasDeadline ? 0 : -1;
+  int hasTerminal = 0;
+
+  for (uint32_t stage = 0; stage < stageCount; stage++)
+  {
+    int pipeFD[2] = {-1, -1};
+    if (stage + 1 < stageCount && pipe2(pipeFD, O_CLOEXEC) == -1)
+    {
+      yash_logMessage("Error: Could not create the pipe.");
+      status = 1;
+      break;
+    }
+
+    // each stage gets its own redirection plan which is applied after the pipes.
+    uint32_t stageNode = yash_buildRedirectPlan(ast, ast->lists[node->left + stage], &plan);
+    const yash_node *command = stageNode != NODE_NONE ? &ast->nodes[stageNode] : NULL;
+    int result = 1;
+    int isExternal = stageArgs[stage].argv != NULL && !yash_isBuiltin(stageArgs[stage].argv[0]);
+
+    // a stage which is a builtin, an assignment or not a simple command runs in a copy of the shell.
+    if (isExternal && !stageArgs[stage].hasError)
+    {
+      result = yash_spawnCommand(&stageArgs[stage], previousRead, pipeFD[1], pipeFD[0], &plan,
+                                 &children[childCount]);
+    }
+    else if (command != NULL && !isExternal)
+    {
+      memset(&children[childCount], 0, sizeof(yash_child));
+      uint32_t shellNode = command->type == NODE_SUBSHELL ? command->left : stageNode;
+      children[childCount].pid = yash_forkShell(ast, shellNode, previousRead, pipeFD[1], pipeFD[0], &plan);
+      result = children[childCount].pid == -1 ? 1 : 0;
+    }
+    yash_freeRedirectPlan(&plan);
+
+    if (result == 0)
+    {
+      childCount++;
+    }
+
+    // the terminal is given as soon as the group exists so the first stage
+    // does not have to wait for the others to read from it.
+    if (pipelineGroup > 0 && !hasTerminal)
+    {
+      yash_giveTerminal(pipelineGroup);
+      hasTerminal = 1;
+    }
+    if (stage + 1 == stageCount)
+    {
+      status = result;
+    }
+
+    if (previousRead != -1)
+    {
+      close(previousRead);
+    }
+    if (pipeFD[1] != -1)
+    {
+      close(pipeFD[1]);
+    }
+    previousRead = pipeFD[0];
+
+    // the pipe of the relay is made after the stage is started so the stage does not
+    // get it. The copies of the shell for the next stages close it from activeProfile.
+    if (isProfiled)
+    {
+      const char *name = stageArgs[stage].argv != NULL ? stageArgs[stage].argv[0] : "(commands)";
+      snprintf(stageNames[stage], PROFILE_NAME_SIZE, "%s", name);
+      for (int arg = 1; stageArgs[stage].argv != NULL && arg < stageArgs[stage].argc; arg++)
+      {
+        size_t length = strlen(stageNames[stage]);
+        snprintf(stageNames[stage] + length, PROFILE_NAME_SIZE - length, " %s", stageArgs[stage].argv[arg]);
+      }
+
+      int relayFD[2];
+      if (previousRead != -1 && pipe2(relayFD, O_CLOEXEC) == 0)
+      {
+        // bigger pipes let each splice move more, it is fine if the size can not be changed.
+        fcntl(previousRead, F_SETPIPE_SZ, PROFILE_PIPE_SIZE);
+        fcntl(relayFD[1], F_SETPIPE_SZ, PROFILE_PIPE_SIZE);
+        relays[profile.relayCount].inFD = previousRead;
+        relays[profile.relayCount].outFD = relayFD[1];
+        profile.relayCount++;
+        previousRead = relayFD[0];
+      }
+      else if (previousRead != -1)
+      {
+        yash_logMessage("Error: profile: Could not create the pipe of a relay.");
+      }
+    }
+  }
+  if (previousRead != -1)
+  {
+    close(previousRead);
+  }
+
+  // the stages run by a copy of the shell are stopped with the group, they get the
+  // deadline of the pipeline so they also exit with TIMEOUT_EXIT_STATUS.
+  for (int index = 0; pipelineGroup > 0 && index < childCount; index++)
+  {
+    if (children[index].cmdArgs == NULL)
+    {
+      children[index].processGroup = pipelineGroup;
+      children[index].deadline = pipelineDeadline;
+      children[index].killAfter = TIMEOUT_KILL_AFTER_NANOS;
+    }
+  }
+
+  if (isProfiled)
+  {
+    yash_startProfile(&profile);
+  }
+  yash_waitChildren(children, childCount);
+  if (hasTerminal)
+  {
+    yash_takeTerminal();
+  }
+  pipelineGroup = -1;
+  if (isProfiled)
+  {
+    yash_finishProfile(&profile);
+  }
+
+  // the last stage was started only if its result was zero.
+  if (status == 0 && childCount > 0)
+  {
+    status = yash_childStatus(&children[childCount - 1]);
+  }
+  for (uint32_t stage = 0; stage < stageCount; stage++)
+  {
+    if (stageArgs[stage].argv != NULL)
+    {
+      yash_freeArgs(&stageArgs[stage]);
+    }
+  }
+  return status;
+}
+
+// this is the function used to run a command in background, a simple command is started
+// with yash_execute_in_bg and anything else like a group or a pipeline is run by a
+// copy of the shell in its own session. The redirections are applied in the child.
+int yash_executeInBackground(const yash_ast *ast, uint32_t node)
+{
+  yash_redirectPlan plan;
+  uint32_t inner = yash_buildRedirectPlan(ast, node, &plan);
+  if (inner == NODE_NONE)
+  {
+    yash_freeRedirectPlan(&plan);
+    return 1;
+  }
+
+  // a command with only assignments is run by the copy of the shell like a builtin.
+  const yash_node *command = &ast->nodes[inner];
+  if (command->type == NODE_COMMAND && command->extra < command->right)
+  {
+    yash_args args;
+    yash_expandCommand(ast, command, &args);
+    int status = args.hasError ? 1 : yash_isBuiltin(args.argv[0]) ? -1 : yash_execute_in_bg(&args, &plan);
+    yash_freeArgs(&args);
+    if (status != -1)
+    {
+      yash_freeRedirectPlan(&plan);
+      return status;
+    }
+  }
+
+  int64_t startTime = yash_realtimeNanos();
+  int64_t startClock = yash_monotonicNanos();
+  fflush(NULL);
+  pid_t child = fork();
+  if (child == -1)
+  {
+    yash_logMessage("Error creating child for bg process.");
+    yash_freeRedirectPlan(&plan);
+    return 1;
+  }
+  if (child == 0)
+  {
+    setsid();
+    signal(SIGTTOU, SIG_DFL);
+    signal(SIGINT, SIG_DFL);
+    yash_applyRedirectPlan(&plan);
+    yash_auditAfterFork();
+    bgProcessListPointer = -1;
+    int status = yash_executeNode(ast, inner);
+    fflush(NULL);
+    _exit(status);
+  }
+  yash_freeRedirectPlan(&plan);
+
+  char *processDetails = malloc(sizeof(char) * 64);
+  snprintf(processDetails, 64, "[%d] (commands)", child);
+  char *commandsArgs[] = {"(commands)"};
+  yash_addBackgroundProcess(child, processDetails, commandsArgs, 1, startTime, startClock);
+  return 0;
+}
+
+// this is the function used to run a part of the tree in a copy of the shell with
+// a redirection plan and wait for it, it returns the exit status of the copy.
+int yash_executeForked(const yash_ast *ast, uint32_t node, const yash_redirectPlan *plan)
+{
+  pid_t child = yash_forkShell(ast, node, -1, -1, -1, plan);
+  if (child == -1)
+  {
+    return 1;
+  }
+
+  int status = 0;
+  while (waitpid(child, &status, 0) == -1 && errno == EINTR)
+  {
+  }
+  return yash_exitStatus(status);
+}
+
+// this is the function used to run a builtin or an assignment with its redirections in the
+// shell itself. stdin, stdout and stderr are saved with F_DUPFD_CLOEXEC, the plan is applied
+// and they are restored after, also when a file of the plan could not be opened. Only these
+// three fds can be redirected, the others may be fds used by the shell like the audit log.
+int yash_runRedirectedBuiltin(const yash_ast *ast, const yash_node *command, const yash_args *args,
+                              const yash_redirectPlan *plan)
+{
+  const char *name = command->extra == command->right ? "assignment" : args->argv[0];
+  for (int index = 0; index < plan->count; index++)
+  {
+    if (plan->redirects[index].fd > STDERR_FILENO || plan->redirects[index].targetFD > STDERR_FILENO)
+    {
+      fprintf(stderr, "yash: %s: only fds 0, 1 and 2 can be redirected for a builtin \n", name);
+      return 1;
+    }
+  }
+
+  fflush(NULL);
+  int savedFDs[3];
+  for (int fd = 0; fd < 3; fd++)
+  {
+    savedFDs[fd] = fcntl(fd, F_DUPFD_CLOEXEC, 10);
+  }
+
+  int status = 1;
+  if (yash_applyRedirects(plan) == 0)
+  {
+    status = command->extra == command->right ? yash_assignVariables(ast, command)
+                                              : yash_runBuiltin(args->argv, args->argc);
+  }
+
+  // an fd which was closed before is closed again.
+  fflush(NULL);
+  for (int fd = 0; fd < 3; fd++)
+  {
+    if (savedFDs[fd] >= 0)
+    {
+      dup2(savedFDs[fd], fd);
+      close(savedFDs[fd]);
+    }
+    else
+    {
+      close(fd);
+    }
+  }
+  return status;
+}
+
+// this is the function used to execute a node with redirections. A command gets the plan
+// applied in its child and a group or a subshell runs in a copy of the shell which applies
+// the plan first. the builtins and the assignments run in the shell itself, so for them the
+// plan is applied around the builtin and the fds of the shell are restored after it.
+int yash_executeRedirect(const yash_ast *ast, uint32_t node)
+{
+  yash_redirectPlan plan;
+  uint32_t inner = yash_buildRedirectPlan(ast, node, &plan);
+  int status = 1;
+  if (inner == NODE_NONE)
+  {
+    yash_freeRedirectPlan(&plan);
+    return status;
+  }
+
+  const yash_node *command = &ast->nodes[inner];
+  if (command->type == NODE_COMMAND)
+  {
+    yash_args args;
+    int isAssignment = command->extra == command->right;
+    memset(&args, 0, sizeof(args));
+    if (!isAssignment)
+    {
+      yash_expandCommand(ast, command, &args);
+    }
+    pipelineDeadline = 0;
+    if (args.hasError)
+    {
+      status = 1;
+    }
+    else if (isAssignment || yash_isBuiltin(args.argv[0]))
+    {
+      status = yash_runRedirectedBuiltin(ast, command, &args, &plan);
+    }
+    else
+    {
+      status = yash_executeCommand(&args, &plan);
+    }
+    yash_freeArgs(&args);
+  }
+  else
+  {
+    // a subshell is already run by the copy so its list is run directly.
+    status = yash_executeForked(ast, command->type == NODE_SUBSHELL ? command->left : inner, &plan);
+  }
+
+  yash_freeRedirectPlan(&plan);
+  return status;
+}
+
+// this is the function used to execute the watch and onchange builtins,
+// the last word of the list is the text of the command printed by watch.
+int yash_executeWatch(const yash_ast *ast, const yash_node *node)
+{
+  yash_args args;
+  yash_expandArgs(ast, node->right, node->extra - 1, &args);
+  const char *commandText = ast->strings + ast->nodes[ast->lists[node->right + node->extra - 1]].left;
+
+  int status;
+  if (strcmp(args.argv[0], "watch") == 0)
+  {
+    status = yash_watch(args.argv, args.argc, commandText, ast, node->left);
+  }
+  else
+  {
+    status = yash_onChange(args.argv, args.argc, ast, node->left);
+  }
+  yash_freeArgs(&args);
+  return status;
+}
+
+// this is the function used to check if a break or continue is leaving the loop,
+// the lists stop running their commands until the loop is reached.
+int yash_isLeavingLoop()
+{
+  return breakLevels > 0 || continueLevels > 0;
+}
+
+// this is the function used at the end of an iteration of a loop, it returns 1 if the
+// loop has to stop because of break or because continue is for an outer loop.
+int yash_endLoopIteration()
+{
+  if (breakLevels > 0)
+  {
+    breakLevels--;
+    return 1;
+  }
+  if (continueLevels > 0)
+  {
+    continueLevels--;
+    return continueLevels > 0;
+  }
+  return isLoopInterrupted;
+}
+
+// this is the function used to execute while and until loops, the status is the one of
+// the last run of the body or 0 if it never ran. Ctrl-C stops the loop.
+int yash_executeWhile(const yash_ast *ast, const yash_node *node)
+{
+  int status = 0;
+  loopDepth++;
+  while (!isLoopInterrupted)
+  {
+    int condition = yash_executeNode(ast, node->left);
+    if (yash_isLeavingLoop())
+    {
+      if (yash_endLoopIteration())
+      {
+        break;
+      }
+      continue;
+    }
+    if ((condition == 0) == (node->extra == 1))
+    {
+      break;
+    }
+
+    status = yash_executeNode(ast, node->right);
+    if (yash_endLoopIteration())
+    {
+      break;
+    }
+  }
+  loopDepth--;
+  return status;
+}
+
+// this is the function used to execute a for loop, the words are expanded once
+// before the first iteration.
+int yash_executeFor(const yash_ast *ast, const yash_node *node)
+{
+  const yash_node *wordList = &ast->nodes[node->extra];
+  const char *name = ast->strings + node->left;
+  yash_args words;
+  yash_expandArgs(ast, wordList->left, wordList->right, &words);
+  if (words.hasError)
+  {
+    yash_freeArgs(&words);
+    return 1;
+  }
+
+  int status = 0;
+  loopDepth++;
+  for (int index = 0; index < words.argc && !isLoopInterrupted; index++)
+  {
+    yash_setVariableText(name, words.argv[index]);
+    status = yash_executeNode(ast, node->right);
+    if (yash_endLoopIteration())
+    {
+      break;
+    }
+  }
+  loopDepth--;
+  yash_freeArgs(&words);
+  return status;
+}
+
+// this is the executor, it walks the tree from the given node and returns the exit
+// status, which is also stored for $?. && and || run their right side depending on the
+// status of the left side and a list runs its commands one after the other.
+// after break or continue the rest of the lists and && and || is skipped until the loop.
+int yash_executeNode(const yash_ast *ast, uint32_t node)
+{
+  const yash_node *current = &ast->nodes[node];
+  int status = 0;
+  int hasError = 0;
+
+  switch (current->type)
+  {
+  case NODE_COMMAND:
+    status = yash_executeSimpleCommand(ast, current);
+    break;
+  case NODE_PIPELINE:
+    status = yash_executePipeline(ast, current);
+    break;
+  case NODE_AND:
+    status = yash_executeNode(ast, current->left);
+    if (status == 0 && !yash_isLeavingLoop())
+    {
+      status = yash_executeNode(ast, current->right);
+    }
+    break;
+  case NODE_OR:
+    status = yash_executeNode(ast, current->left);
+    if (status != 0 && !yash_isLeavingLoop())
+    {
+      status = yash_executeNode(ast, current->right);
+    }
+    break;
+  case NODE_LIST:
+    for (uint32_t index = 0; index < current->right && !yash_isLeavingLoop(); index++)
+    {
+      status = yash_executeNode(ast, ast->lists[current->left + index]);
+    }
+    break;
+  case NODE_IF:
+    status = yash_executeNode(ast, current->left);
+    if (yash_isLeavingLoop())
+    {
+      break;
+    }
+    if (status == 0)
+    {
+      status = yash_executeNode(ast, current->right);
+    }
+    else
+    {
+      status = current->extra != NODE_NONE ? yash_executeNode(ast, current->extra) : 0;
+    }
+    break;
+  case NODE_WHILE:
+    status = yash_executeWhile(ast, current);
+    break;
+  case NODE_FOR:
+    status = yash_executeFor(ast, current);
+    break;
+  case NODE_ARITH_COMMAND:
+    status = yash_evaluateArithmetic(ast, current->left, &hasError) != 0 ? 0 : 1;
+    status = hasError ? 1 : status;
+    break;
+  case NODE_BACKGROUND:
+    status = yash_executeInBackground(ast, current->left);
+    break;
+  case NODE_SUBSHELL:
+    status = yash_executeForked(ast, current->left, NULL);
+    break;
+  case NODE_GROUP:
+    status = yash_executeNode(ast, current->left);
+    break;
+  case NODE_REDIRECT:
+    status = yash_executeRedirect(ast, node);
+    break;
+  case NODE_WATCH:
+    status = yash_executeWatch(ast, current);
+    break;
+  }
+
+  lastExitStatus = status;
+  return status;
+}
+
+// this is the function which parses and executes one prompt of the user.
+// if isPrompt is set and the command is not complete, like an if without its fi,
+// nothing is executed and it returns -2 so the next line can be read.
+int yash_runPrompt(const char *prompt, int isPrompt)
+{
+  yash_ast ast;
+  int result = yash_parse(prompt, strlen(prompt), &ast, isPrompt);
+  if (result != 0)
+  {
+    lastExitStatus = result == -1 ? 2 : lastExitStatus;
+    return result;
+  }
+  if (ast.root != NODE_NONE)
+  {
+    int64_t start = yash_monotonicNanos();
+    isLoopInterrupted = 0;
+    yash_executeNode(&ast, ast.root);
+    lastCommandEnd = yash_monotonicNanos();
+    lastCommandNanos = lastCommandEnd - start;
+  }
+  yash_freeAst(&ast);
+  return 0;
+}
+
+// this is the function used to point the sections of the tree
+// to the right places in the image after it is mapped.
+void yash_bindAst(yash_ast *ast, void *image, size_t imageSize)
+{
+  const yash_scriptHeader *header = image;
+  memset(ast, 0, sizeof(*ast));
+  ast->image = image;
+  ast->imageSize = imageSize;
+  ast->nodes = (yash_node *)(header + 1);
+  ast->nodeCount = header->nodeCount;
+  ast->lists = (uint32_t *)(ast->nodes + header->nodeCount);
+  ast->listCount = header->listCount;
+  ast->strings = (char *)(ast->lists + header->listCount);
+  ast->stringBytes = header->stringBytes;
+  ast->root = header->root;
+}
+
+// this is the function which returns the size of the image for the given counts.
+size_t yash_scriptImageSize(uint64_t nodeCount, uint64_t listCount, uint64_t stringBytes)
+{
+  return sizeof(yash_scriptHeader) + sizeof(yash_node) * nodeCount + sizeof(uint32_t) * listCount + stringBytes;
+}
+
+// this is the function used to get the path of the cache file for a script.
+// the file name is made of device and inode so renaming the script keeps the cache,
+// the size and mtime are checked from the header when the cache is loaded.
+// the cache lives in $XDG_CACHE_HOME/yash or $HOME/.cache/yash.
+int yash_scriptCachePath(const struct stat *fileInfo, char *path, size_t pathSize, int createDirectory)
+{
+  char directory[PATH_MAX];
+  char *cacheHome = getenv("XDG_CACHE_HOME");
+  char *home = getenv("HOME");
+
+  if (cacheHome != NULL && cacheHome[0] == '/')
+  {
+    snprintf(directory, sizeof(directory), "%s", cacheHome);
+  }
+  else if (home != NULL && home[0] == '/')
+  {
+    snprintf(directory, sizeof(directory), "%s/.cache", home);
+  }
+  else
+  {
+    return -1;
+  }
+
+  if (createDirectory)
+  {
+    mkdir(directory, 0700);
+  }
+  strncat(directory, "/yash", sizeof(directory) - strlen(directory) - 1);
+  if (createDirectory && mkdir(directory, 0700) == -1 && errno != EEXIST)
+  {
+    return -1;
+  }
+
+  int length = snprintf(path, pathSize, "%s/%llx-%llx%s", directory,
+                        (unsigned long long)fileInfo->st_dev,
+                        (unsigned long long)fileInfo->st_ino, SCRIPT_CACHE_SUFFIX);
+  if (length < 0 || (size_t)length >= pathSize)
+  {
+    return -1;
+  }
+  return 0;
+}
+
+// this is the function used to load the compiled script from the cache using mmap.
+// the cache is only used if the header matches the inode, mtime and size of the script
+// and the sections fit in the file, otherwise -1 is returned and the script is parsed again.
+int yash_loadScriptCache(const struct stat *fileInfo, yash_ast *ast)
+{
+  char path[PATH_MAX];
+  if (yash_scriptCachePath(fileInfo, path, sizeof(path), 0) == -1)
+  {
+    return -1;
+  }
+
+  int fileDescriptor = open(path, O_RDONLY | O_CLOEXEC);
+  if (fileDescriptor < 0)
+  {
+    return -1;
+  }
+
+  struct stat cacheInfo;
+  if (fstat(fileDescriptor, &cacheInfo) == -1 || (size_t)cacheInfo.st_size < sizeof(yash_scriptHeader))
+  {
+    close(fileDescriptor);
+    return -1;
+  }
+
+  void *image = mmap(NULL, cacheInfo.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+  close(fileDescriptor);
+  if (image == MAP_FAILED)
+  {
+    return -1;
+  }
+
+  const yash_scriptHeader *header = image;
+  if (memcmp(header->magic, SCRIPT_CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != SCRIPT_CACHE_VERSION ||
+      header->device != (uint64_t)fileInfo->st_dev ||
+      header->inode != (uint64_t)fileInfo->st_ino ||
+      header->size != (uint64_t)fileInfo->st_size ||
+      header->mtimeSec != fileInfo->st_mtim.tv_sec ||
+      header->mtimeNsec != fileInfo->st_mtim.tv_nsec ||
+      yash_scriptImageSize(header->nodeCount, header->listCount, header->stringBytes) != (size_t)cacheInfo.st_size)
+  {
+    munmap(image, cacheInfo.st_size);
+    return -1;
+  }
+
+  // the tree is checked once here so the executor can trust the indexes.
+  yash_bindAst(ast, image, cacheInfo.st_size);
+  if (yash_checkAst(ast) == -1)
+  {
+    yash_freeAst(ast);
+    return -1;
+  }
+  return 0;
+}
+
+// this is the function used to write the compiled tree to the cache.
+// the header and the sections are written with one writev to a temporary file
+// first and then renamed so a reader never sees a half written cache file.
+void yash_saveScriptCache(const struct stat *fileInfo, const yash_ast *ast)
+{
+  char path[PATH_MAX];
+  char temporaryPath[PATH_MAX + 32];
+  if (yash_scriptCachePath(fileInfo, path, sizeof(path), 1) == -1)
+  {
+    return;
+  }
+  snprintf(temporaryPath, sizeof(temporaryPath), "%s.%d", path, getpid());
+
+  int fileDescriptor = open(temporaryPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fileDescriptor < 0)
+  {
+    return;
+  }
+
+  yash_scriptHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SCRIPT_CACHE_MAGIC, sizeof(header.magic));
+  header.version = SCRIPT_CACHE_VERSION;
+  header.nodeCount = ast->nodeCount;
+  header.listCount = ast->listCount;
+  header.stringBytes = ast->stringBytes;
+  header.root = ast->root;
+  header.device = fileInfo->st_dev;
+  header.inode = fileInfo->st_ino;
+  header.size = fileInfo->st_size;
+  header.mtimeSec = fileInfo->st_mtim.tv_sec;
+  header.mtimeNsec = fileInfo->st_mtim.tv_nsec;
+
+  struct iovec sections[4] = {
+      {&header, sizeof(header)},
+      {ast->nodes, sizeof(yash_node) * ast->nodeCount},
+      {ast->lists, sizeof(uint32_t) * ast->listCount},
+      {ast->strings, ast->stringBytes}};
+  size_t imageSize = yash_scriptImageSize(ast->nodeCount, ast->listCount, ast->stringBytes);
+  size_t written = 0;
+  int section = 0;
+  while (written < imageSize)
+  {
+    ssize_t count = writev(fileDescriptor, sections + section, 4 - section);
+    if (count < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (count <= 0)
+    {
+      break;
+    }
+    written += count;
+
+    // after a short write the sections which are done are skipped.
+    while (section < 4 && (size_t)count >= sections[section].iov_len)
+    {
+      count -= sections[section].iov_len;
+      section++;
+    }
+    if (section < 4)
+    {
+      sections[section].iov_base = (char *)sections[section].iov_base + count;
+      sections[section].iov_len -= count;
+    }
+  }
+  close(fileDescriptor);
+
+  if (written != imageSize || rename(temporaryPath, path) == -1)
+  {
+    unlink(temporaryPath);
+  }
+}
+
+// this is the function used to read the source of the script and parse it into the tree.
+// the whole file is parsed at once so a syntax error stops the script before anything runs.
+int yash_parseScriptFile(int fileDescriptor, const struct stat *fileInfo, yash_ast *ast)
+{
+  size_t sourceSize = fileInfo->st_size;
+  if (sourceSize >= UINT32_MAX)
+  {
+    yash_logMessage("Error: Script is too large to be compiled.");
+    return -1;
+  }
+
+  char *source = malloc(sourceSize + 1);
+  size_t bytesRead = 0;
+  while (bytesRead < sourceSize)
+  {
+    ssize_t count = pread(fileDescriptor, source + bytesRead, sourceSize - bytesRead, bytesRead);
+    if (count < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (count <= 0)
+    {
+      break;
+    }
+    bytesRead += count;
+  }
+  source[bytesRead] = '\0';
 
-        // getting the current command's tokens before the pipe in command vector variable.
-        commandEndPointer = iterator;
-        int argsCount = commandEndPointer - commandStartPointer;
-        char *commandVector[argsCount];
+  int result = yash_parse(source, bytesRead, ast, 0);
+  free(source);
+  return result;
+}
 
-        for (int iterator1 = 0; iterator1 < argsCount; iterator1++)
-        {
-          commandVector[iterator1] = userPromptList[iterator1 + commandStartPointer];
-        }
+// this is the function used to get the compiled script for a file.
+// if the cache is enabled it is loaded from cache and only parsed when the
+// cache is missing or stale, in that case the cache is written again.
+int yash_loadScript(const char *scriptPath, yash_ast *ast)
+{
+  int fileDescriptor = open(scriptPath, O_RDONLY | O_CLOEXEC);
+  if (fileDescriptor < 0)
+  {
+    yash_logMessage("Error: There was some error opening the script. Check if the file exist.");
+    return -1;
+  }
 
-        // calling the pipe to get read and write file descriptor.
-        pipe(pipeFD);
+  // the identity is taken from the opened file so the
+  // source which is parsed is the same which is used as key.
+  struct stat fileInfo;
+  if (fstat(fileDescriptor, &fileInfo) == -1 || !S_ISREG(fileInfo.st_mode))
+  {
+    yash_logMessage("Error: Script must be a regular file.");
+    close(fileDescriptor);
+    return -1;
+  }
 
-        // if there are more than 1 commands before this pipe
-        // then I am redirecting the stdin of current command to previous command's
-        // write end of the pipe.
-        if (commandsCounter > 0)
-        {
-          dup2(prev_pipeFD, STDIN_FILENO);
-          close(prev_pipeFD);
-        }
+  if (!isScriptCacheDisabled && yash_loadScriptCache(&fileInfo, ast) == 0)
+  {
+    close(fileDescriptor);
+    return 0;
+  }
 
-        // stdout to the write end of current command's pipe
-        dup2(pipeFD[1], STDOUT_FILENO);
-        close(pipeFD[1]);
+  int result = yash_parseScriptFile(fileDescriptor, &fileInfo, ast);
+  close(fileDescriptor);
 
-        // then executing the command
-        yash_executeCommand(commandVector[0], commandVector, argsCount);
+  if (result == 0 && !isScriptCacheDisabled)
+  {
+    yash_saveScriptCache(&fileInfo, ast);
+  }
+  return result;
+}
 
-        // and saving the read end as prev pipe for further use be other commands.
-        prev_pipeFD = pipeFD[0];
+// this is the function used to execute a script file, the tree is executed from
+// the root and the exit status of the script is the status of its last command.
+int yash_runScript(const char *scriptPath)
+{
+  yash_ast ast;
+  if (yash_loadScript(scriptPath, &ast) == -1)
+  {
+    return 2;
+  }
 
-        // at last I am upating the pointers which keeps track of the commands
-        // in token list.
-        commandStartPointer = iterator + 1;
-        commandsCounter++;
-      }
-      // if the operator is > then it is redirecting the output of left hand side
-      // of operator to file mentioned in right hand side. In this if the file does not exist
-      // it will be created and the content will be replaced by the output of command.
-      else if (strcmp(userPromptList[iterator], ">") == 0)
-      {
+  if (ast.root != NODE_NONE)
+  {
+    yash_executeNode(&ast, ast.root);
+  }
+  fflush(NULL);
+  yash_freeAst(&ast);
+  return lastExitStatus;
+}
 
-        lastSpecialCharacter = ">";
-        // here I am opening/creating the file
-        int fileDescriptor = open(userPromptList[iterator + 1], O_WRONLY | O_CREAT | O_TRUNC, 0666);
-        // redirecing the standard ouput to the file so what
-        // ever will be output of command it will be stored in file
-        dup2(fileDescriptor, STDOUT_FILENO);
-        close(fileDescriptor);
+// this is the function used to compare cold and warm start of a script,
+// cold is reading and parsing the source and warm is loading it from the cache.
+// each is repeated for the given iterations and the average time is printed.
+int yash_benchScriptCache(const char *scriptPath, long iterations)
+{
+  int fileDescriptor = open(scriptPath, O_RDONLY | O_CLOEXEC);
+  struct stat fileInfo;
+  if (fileDescriptor < 0 || fstat(fileDescriptor, &fileInfo) == -1 || !S_ISREG(fileInfo.st_mode))
+  {
+    yash_logMessage("Error: There was some error opening the script. Check if the file exist.");
+    return EXIT_FAILURE;
+  }
 
-        // again getting the current command's tokens before the operator in command vector variable.
-        commandEndPointer = iterator;
-        int argsCount = commandEndPointer - commandStartPointer;
-        char *commandVector[argsCount];
+  yash_ast ast;
+  if (yash_parseScriptFile(fileDescriptor, &fileInfo, &ast) == -1)
+  {
+    close(fileDescriptor);
+    return EXIT_FAILURE;
+  }
+  yash_saveScriptCache(&fileInfo, &ast);
+  yash_freeAst(&ast);
 
-        for (int iterator1 = 0; iterator1 < argsCount; iterator1++)
-        {
-          commandVector[iterator1] = userPromptList[iterator1 + commandStartPointer];
-        }
-        // at last executing the command
-        yash_executeCommand(commandVector[0], commandVector, argsCount);
-      }
-      // if the operator is >> then the output of the command is redirect to a file
-      // but instead of overwriting, data is appended in the file for each execution of command.
-      else if (strcmp(userPromptList[iterator], ">>") == 0)
-      {
-        lastSpecialCharacter = ">>";
-        // here I am opening/creating the file and
-        // redirecing the standard ouput to the file so what
-        // ever will be output of command it will be stored in file
-        int fileDescriptor = open(userPromptList[iterator + 1], O_WRONLY | O_CREAT | O_APPEND, 0666);
-        dup2(fileDescriptor, STDOUT_FILENO);
-        close(fileDescriptor);
-
-        // again getting the current command's tokens before the operator in command vector variable.
-        commandEndPointer = iterator;
-        int argsCount = commandEndPointer - commandStartPointer;
-        char *commandVector[argsCount];
-
-        for (int iterator1 = 0; iterator1 < argsCount; iterator1++)
-        {
-          commandVector[iterator1] = userPromptList[iterator1 + commandStartPointer];
-        }
+  int64_t start = yash_monotonicNanos();
+  for (long iteration = 0; iteration < iterations; iteration++)
+  {
+    yash_parseScriptFile(fileDescriptor, &fileInfo, &ast);
+    yash_freeAst(&ast);
+  }
+  int64_t cold = yash_monotonicNanos() - start;
 
-        // executing the command.
-        yash_executeCommand(commandVector[0], commandVector, argsCount);
-      }
-      // if the operator is < then the input of the command is redirected from a file.
-      else if (strcmp(userPromptList[iterator], "<") == 0)
-      {
-        // again I am storing the operator in last execution.
-        // opening the file which should already existed.
-        lastSpecialCharacter = "<";
-        int fileDescriptor = open(userPromptList[iterator + 1], O_RDONLY, 0666);
+  start = yash_monotonicNanos();
+  for (long iteration = 0; iteration < iterations; iteration++)
+  {
+    if (yash_loadScriptCache(&fileInfo, &ast) == -1)
+    {
+      yash_logMessage("Error: Script cache could not be written or loaded.");
+      close(fileDescriptor);
+      return EXIT_FAILURE;
+    }
+    yash_freeAst(&ast);
+  }
+  int64_t warm = yash_monotonicNanos() - start;
+  close(fileDescriptor);
 
-        // if the file does not exist I am printing the error message.
-        if (fileDescriptor < 0)
-        {
-          yash_logMessage("Error: There was some error opening the file. Check if the file exist.");
-        }
-        // otherwise I am redirecting the standard input to point to the file.
-        // to get content of the file
-        else
-        {
-          dup2(fileDescriptor, STDIN_FILENO);
-          close(fileDescriptor);
+  printf("script: %s (%lld bytes, %ld iterations)\n", scriptPath, (long long)fileInfo.st_size, iterations);
+  printf("cold start (parse): %10.2f us\n", cold / 1000.0 / iterations);
+  printf("warm start (cache): %10.2f us\n", warm / 1000.0 / iterations);
+  return EXIT_SUCCESS;
+}
 
-          // further I am getting all the tokens related to command and executing it
-          commandEndPointer = iterator;
-          int argsCount = commandEndPointer - commandStartPointer;
-          char *commandVector[argsCount];
+// this is the function used to compile the prompt template into segments. Text and
+// colors become literal segments which are written as they are, the other escapes
+// become segments which are rendered each time:
+//   %d  the current directory, with ~ for the home directory
+//   %g  the git branch with * when there are changes, from the prompt worker
+//   %e  the exit status of the last command when it is not zero
+//   %t  the duration of the last command when it took at least a second
+//   %j  the number of background jobs when there are some
+//   %l  the load average of the last minute, from the prompt worker
+//   %[codes]  the ANSI color codes like %[0;31], %%  a percent sign
+void yash_compilePrompt(const char *template)
+{
+  free(promptTemplate);
+  free(promptLiterals);
+  free(promptSegments);
+  promptTemplate = strdup(template);
+  promptLiterals = malloc(strlen(template) + 1);
+  promptSegments = malloc(sizeof(yash_promptSegment) * (strlen(template) + 1));
+  promptSegmentCount = 0;
+  promptHasWorkerSegment = 0;
 
-          for (int iterator1 = 0; iterator1 < argsCount; iterator1++)
-          {
-            commandVector[iterator1] = userPromptList[iterator1 + commandStartPointer];
-          }
+  size_t literalLength = 0;
+  size_t segmentStart = 0;
+  for (const char *character = template; *character != '\0'; character++)
+  {
+    const char *close = character[0] == '%' && character[1] == '[' ? strchr(character, ']') : NULL;
+    const char *escape = character[0] == '%' && character[1] != '\0' ? strchr(PROMPT_ESCAPES, character[1]) : NULL;
+    if (close != NULL)
+    {
+      literalLength += sprintf(promptLiterals + literalLength, "\033[%.*sm", (int)(close - character - 2),
+                               character + 2);
+      character = close;
+      continue;
+    }
+    if (escape == NULL)
+    {
+      promptLiterals[literalLength++] = *character;
+      character += character[0] == '%' && character[1] == '%';
+      continue;
+    }
+    int type = (int)(escape - PROMPT_ESCAPES) + PROMPT_DIRECTORY;
+    character++;
 
-          yash_executeCommand(commandVector[0], commandVector, argsCount);
-        }
+    // the literal text before a segment is kept as one segment.
+    if (literalLength > segmentStart)
+    {
+      promptSegments[promptSegmentCount++] = (yash_promptSegment){PROMPT_LITERAL, segmentStart,
+                                                                  literalLength - segmentStart};
+    }
+    promptSegments[promptSegmentCount++] = (yash_promptSegment){type, 0, 0};
+    promptHasWorkerSegment |= type == PROMPT_GIT || type == PROMPT_LOAD;
+    segmentStart = literalLength;
+  }
+  if (literalLength > segmentStart)
+  {
+    promptSegments[promptSegmentCount++] = (yash_promptSegment){PROMPT_LITERAL, segmentStart,
+                                                                literalLength - segmentStart};
+  }
+}
+
+// this is the function used to find the git directory of the repository which contains
+// the directory, .git can be a directory or a file with gitdir: for worktrees.
+int yash_findGitDirectory(const char *directory, char *gitDirectory, size_t size)
+{
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s", directory);
+  while (1)
+  {
+    struct stat fileInfo;
+    snprintf(gitDirectory, size, "%s/.git", strcmp(path, "/") == 0 ? "" : path);
+    if (stat(gitDirectory, &fileInfo) == 0 && S_ISDIR(fileInfo.st_mode))
+    {
+      return 0;
+    }
+    if (stat(gitDirectory, &fileInfo) == 0)
+    {
+      FILE *file = fopen(gitDirectory, "r");
+      char line[PATH_MAX];
+      int isFound = file != NULL && fgets(line, sizeof(line), file) != NULL && strncmp(line, "gitdir: ", 8) == 0;
+      if (file != NULL)
+      {
+        fclose(file);
       }
-      // if the operator is & this is to run a command in background.
-      else if (strcmp(userPromptList[iterator], "&") == 0)
+      if (isFound)
       {
-        // first I am storing the operator and then getting the command from list
-        lastSpecialCharacter = "&";
-        commandEndPointer = iterator;
-        int argsCount = commandEndPointer - commandStartPointer;
-        char *commandVector[argsCount];
-
-        for (int iterator1 = 0; iterator1 < argsCount; iterator1++)
+        line[strcspn(line, "\n")] = '\0';
+        if (line[8] == '/')
         {
-          commandVector[iterator1] = userPromptList[iterator1 + commandStartPointer];
+          snprintf(gitDirectory, size, "%s", line + 8);
         }
-
-        // then i am calling execute bg function which is used to send process to background
-        // in this shell will have control over the terminal and can execute commands while other
-        // process is running in the background.
-        yash_execute_in_bg(commandVector[0], commandVector, argsCount);
-      }
-      // if the operation is ; then all the commands are executed sequencially.
-      else if (strcmp(userPromptList[iterator], ";") == 0)
-      {
-        // first I am storing the operator and then getting the command from list
-        lastSpecialCharacter = ";";
-        commandEndPointer = iterator;
-        int argsCount = commandEndPointer - commandStartPointer;
-        char *commandVector[argsCount];
-
-        for (int iterator1 = 0; iterator1 < argsCount; iterator1++)
+        else
         {
-          commandVector[iterator1] = userPromptList[iterator1 + commandStartPointer];
+          snprintf(gitDirectory, size, "%s/%s", strcmp(path, "/") == 0 ? "" : path, line + 8);
         }
+        return 0;
+      }
+    }
 
-        // then executing the command before the special charcter.
-        yash_executeCommand(commandVector[0], commandVector, argsCount);
+    char *slash = strrchr(path, '/');
+    if (slash == NULL || strcmp(path, "/") == 0)
+    {
+      return -1;
+    }
+    if (slash == path)
+    {
+      slash[1] = '\0';
+    }
+    else
+    {
+      *slash = '\0';
+    }
+  }
+}
 
-        // then updating the pointers to point to next command in the prompt
-        commandStartPointer = iterator + 1;
-        commandsCounter++;
-      }
-      // this is the conditional operator && which works like if any of the command fails it will stop
-      // execution at that point. But it will keep on executing commands from left to right
-      // if there is no issue.
-      else if (strcmp(userPromptList[iterator], "&&") == 0)
-      {
-        // first I am storing the operator and then getting the command from list
-        lastSpecialCharacter = "&&";
-        commandEndPointer = iterator;
-        int argsCount = commandEndPointer - commandStartPointer;
-        char *commandVector[argsCount];
+// this is the function used by the prompt worker to check if the work tree has changes,
+// it runs git status in the directory and any output means there are changes.
+int yash_isGitDirty(const char *directory)
+{
+  int outputFD[2];
+  if (pipe2(outputFD, O_CLOEXEC) == -1)
+  {
+    return 0;
+  }
 
-        for (int iterator1 = 0; iterator1 < argsCount; iterator1++)
-        {
-          commandVector[iterator1] = userPromptList[iterator1 + commandStartPointer];
-        }
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, outputFD[1], STDOUT_FILENO);
+  posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+  posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+  char *argv[] = {"git", "--no-optional-locks", "-C", (char *)directory, "status", "--porcelain",
+                  "--untracked-files=no", NULL};
+  pid_t child;
+  int result = posix_spawnp(&child, "git", &actions, NULL, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  close(outputFD[1]);
 
-        // now I am executing the command getting its status.
-        int status = yash_executeCommand(commandVector[0], commandVector, argsCount);
-        commandStartPointer = iterator + 1;
-        commandsCounter++;
+  char output[64];
+  ssize_t count = 0;
+  if (result == 0)
+  {
+    while ((count = read(outputFD[0], output, sizeof(output))) == -1 && errno == EINTR)
+    {
+    }
+    // the rest of the output is not needed, closing the pipe stops git early.
+    close(outputFD[0]);
+    while (waitpid(child, NULL, 0) == -1 && errno == EINTR)
+    {
+    }
+  }
+  else
+  {
+    close(outputFD[0]);
+  }
+  return count > 0;
+}
 
-        // if there is some issue in execution then I am setting the validStatus and then breaking from
-        // loop, which is processing the tokens.
-        if (status == -1)
-        {
-          isLastEndValid = -1;
-          break;
-        }
-      }
-      // this is the conditional operator || it will stop if at the point
-      // where the command executed successfully but keep on executing commands from
-      // left to right if commands are failing.
-      else if (strcmp(userPromptList[iterator], "||") == 0)
-      {
-        // first I am storing the operator and then getting the command from list
-        lastSpecialCharacter = "||";
-        commandEndPointer = iterator;
-        int argsCount = commandEndPointer - commandStartPointer;
-        char *commandVector[argsCount];
+// this is the function used by the prompt worker to make the text of the git segment,
+// the branch is read from HEAD without starting git, only the changes need git status.
+void yash_renderGitSegment(const char *directory, char *text, size_t size)
+{
+  char gitDirectory[PATH_MAX];
+  text[0] = '\0';
+  if (yash_findGitDirectory(directory, gitDirectory, sizeof(gitDirectory)) == -1)
+  {
+    return;
+  }
 
-        for (int iterator1 = 0; iterator1 < argsCount; iterator1++)
-        {
-          commandVector[iterator1] = userPromptList[iterator1 + commandStartPointer];
-        }
+  char headPath[PATH_MAX + 8];
+  snprintf(headPath, sizeof(headPath), "%s/HEAD", gitDirectory);
+  FILE *head = fopen(headPath, "r");
+  char line[256];
+  if (head == NULL || fgets(line, sizeof(line), head) == NULL)
+  {
+    if (head != NULL)
+    {
+      fclose(head);
+    }
+    return;
+  }
+  fclose(head);
+  line[strcspn(line, "\n")] = '\0';
 
-        // then i executed the command if the commad was successful i
-        // am setting the valid status and breaking from loop but if it failed
-        // I am moving to next command
-        int status = yash_executeCommand(commandVector[0], commandVector, argsCount);
-        commandStartPointer = iterator + 1;
-        commandsCounter++;
+  // a detached HEAD is shown with the start of its commit.
+  const char *branch = line;
+  if (strncmp(line, "ref: refs/heads/", 16) == 0)
+  {
+    branch = line + 16;
+  }
+  else if (strlen(line) > 7)
+  {
+    line[7] = '\0';
+  }
+  snprintf(text, size, " (%s%s)", branch, yash_isGitDirty(directory) ? "*" : "");
+}
 
-        if (status == 0)
-        {
-          isLastOrValid = 0;
-          break;
-        }
-      }
+// this is the function used to get the mtimes of HEAD and of the index of a git directory,
+// a checkout, a commit or an add changes one of them. A missing file gets zero.
+void yash_gitStamp(const char *gitDirectory, struct timespec *headTime, struct timespec *indexTime)
+{
+  char path[PATH_MAX + 8];
+  struct stat fileInfo;
+  snprintf(path, sizeof(path), "%s/HEAD", gitDirectory);
+  *headTime = stat(path, &fileInfo) == 0 ? fileInfo.st_mtim : (struct timespec){0, 0};
+  snprintf(path, sizeof(path), "%s/index", gitDirectory);
+  *indexTime = stat(path, &fileInfo) == 0 ? fileInfo.st_mtim : (struct timespec){0, 0};
+}
 
-      iterator++;
+// this is the prompt worker thread, it computes the slow segments for the directory
+// requested by the prompt and stores them in the cache. The prompt only waits a short
+// bounded time for it, a later result is shown by the next prompt after it is ready.
+void *yash_promptWorkerThread(void *argument)
+{
+  (void)argument;
+  char directory[PATH_MAX];
+  pthread_mutex_lock(&promptWorker.lock);
+  while (1)
+  {
+    while (!promptWorker.hasRequest)
+    {
+      pthread_cond_wait(&promptWorker.wake, &promptWorker.lock);
     }
+    promptWorker.hasRequest = 0;
+    snprintf(directory, sizeof(directory), "%s", promptWorker.requestedDirectory);
+    pthread_mutex_unlock(&promptWorker.lock);
 
-    // this is a cleanup code if the operators were conditional operator.
-    // In this I am resting the stdin and stdout and freeing space used for  user prompts.
-    if ((strcmp(lastSpecialCharacter, "&&") == 0 && isLastEndValid == -1) ||
-        (strcmp(lastSpecialCharacter, "||") == 0 && isLastOrValid == 0))
+    // the mtimes are taken before git runs, so a change during the run is seen by the prompt.
+    char gitDirectory[PATH_MAX] = "";
+    struct timespec headTime = {0, 0};
+    struct timespec indexTime = {0, 0};
+    if (yash_findGitDirectory(directory, gitDirectory, sizeof(gitDirectory)) == 0)
     {
-      yash_cleanUp();
-      continue;
+      yash_gitStamp(gitDirectory, &headTime, &indexTime);
+    }
+    else
+    {
+      gitDirectory[0] = '\0';
+    }
+
+    char gitText[PROMPT_SEGMENT_SIZE];
+    yash_renderGitSegment(directory, gitText, sizeof(gitText));
+    char loadText[PROMPT_SEGMENT_SIZE] = "";
+    FILE *loadFile = fopen("/proc/loadavg", "r");
+    double load;
+    if (loadFile != NULL && fscanf(loadFile, "%lf", &load) == 1)
+    {
+      snprintf(loadText, sizeof(loadText), " load:%.2f", load);
+    }
+    if (loadFile != NULL)
+    {
+      fclose(loadFile);
     }
 
-    // this is the conditions for the special characters redirection and background process
-    // where I am reseting the stdin and stdout and freeing the memory
-    if (strcmp(lastSpecialCharacter, ">") == 0 ||
-        strcmp(lastSpecialCharacter, ">>") == 0 ||
-        strcmp(lastSpecialCharacter, "<") == 0 ||
-        strcmp(lastSpecialCharacter, "&") == 0)
+    // the entry of the directory is updated, or the oldest entry is replaced.
+    pthread_mutex_lock(&promptWorker.lock);
+    yash_promptCacheEntry *entry = &promptWorker.cache[0];
+    for (int index = 0; index < PROMPT_CACHE_SIZE; index++)
     {
-      if (dup2(original_stdout, STDOUT_FILENO) == -1)
+      yash_promptCacheEntry *current = &promptWorker.cache[index];
+      if (strcmp(current->directory, directory) == 0)
       {
-        yash_logMessage("Error while reseting stdout");
-        exit(EXIT_FAILURE);
+        entry = current;
+        break;
       }
-
-      if (dup2(original_stdin, STDIN_FILENO) == -1)
+      if (current->updatedAt < entry->updatedAt)
       {
-        yash_logMessage("Error while reseting stdin");
-        exit(EXIT_FAILURE);
+        entry = current;
       }
+    }
+    snprintf(entry->directory, sizeof(entry->directory), "%s", directory);
+    snprintf(entry->git, sizeof(entry->git), "%s", gitText);
+    snprintf(entry->gitDirectory, sizeof(entry->gitDirectory), "%s", gitDirectory);
+    entry->headTime = headTime;
+    entry->indexTime = indexTime;
+    snprintf(promptWorker.load, sizeof(promptWorker.load), "%s", loadText);
+    entry->updatedAt = yash_monotonicNanos();
+    pthread_cond_broadcast(&promptWorker.done);
+  }
+  return NULL;
+}
 
-      yash_cleanUp();
-      continue;
+// this is the function used to find the cache entry of a directory, it returns NULL if there is none.
+yash_promptCacheEntry *yash_findPromptCacheEntry(const char *directory)
+{
+  for (int index = 0; index < PROMPT_CACHE_SIZE; index++)
+  {
+    if (strcmp(promptWorker.cache[index].directory, directory) == 0)
+    {
+      return &promptWorker.cache[index];
     }
+  }
+  return NULL;
+}
+
+// this is the function used to get the slow segments of the directory from the cache
+// and to ask the worker to compute them again if a command ran since they were computed.
+// the cached segments are used right away, the prompt only waits for the worker for at
+// most PROMPT_WAIT_NANOS when the directory is new or the command changed HEAD or the
+// index of the repository, and uses the old segments if git is slower than that.
+// it only takes the lock, which the worker never holds while it runs git.
+void yash_readPromptCache(const char *directory, char *git, char *load)
+{
+  pthread_mutex_lock(&promptWorker.lock);
+  if (!promptWorker.isStarted)
+  {
+    // the condition of the results uses the monotonic clock for its timed wait.
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&promptWorker.done, &attributes);
+    pthread_condattr_destroy(&attributes);
 
-    // this is the code to execute the last command given in prompt it could be last
-    // if there are multiple commands seperated by special characters or it could be the only commnd
-    // given in prompt.
-    commandEndPointer = iterator;
-    int argsCount = commandEndPointer - commandStartPointer;
-    char *commandVector[argsCount];
+    // the worker must not get the signals of the shell like SIGINT.
+    sigset_t allSignals, previousSignals;
+    sigfillset(&allSignals);
+    pthread_sigmask(SIG_BLOCK, &allSignals, &previousSignals);
+    promptWorker.isStarted = pthread_create(&promptWorker.thread, NULL, yash_promptWorkerThread, NULL) == 0;
+    pthread_sigmask(SIG_SETMASK, &previousSignals, NULL);
+    if (promptWorker.isStarted)
+    {
+      pthread_detach(promptWorker.thread);
+    }
+  }
 
-    for (int iterator1 = 0; iterator1 < argsCount; iterator1++)
+  yash_promptCacheEntry *entry = yash_findPromptCacheEntry(directory);
+  int isStale = entry == NULL || entry->updatedAt < lastCommandEnd;
+  if (isStale && promptWorker.isStarted)
+  {
+    if (!(promptWorker.hasRequest && strcmp(promptWorker.requestedDirectory, directory) == 0))
     {
-      commandVector[iterator1] = userPromptList[iterator1 + commandStartPointer];
+      snprintf(promptWorker.requestedDirectory, sizeof(promptWorker.requestedDirectory), "%s", directory);
+      promptWorker.hasRequest = 1;
+      pthread_cond_signal(&promptWorker.wake);
     }
+  }
+
+  // the two stats are done with the lock held but they never wait for git.
+  int isChanged = entry == NULL;
+  if (entry != NULL && entry->gitDirectory[0] != '\0')
+  {
+    struct timespec headTime;
+    struct timespec indexTime;
+    yash_gitStamp(entry->gitDirectory, &headTime, &indexTime);
+    isChanged = headTime.tv_sec != entry->headTime.tv_sec || headTime.tv_nsec != entry->headTime.tv_nsec ||
+                indexTime.tv_sec != entry->indexTime.tv_sec || indexTime.tv_nsec != entry->indexTime.tv_nsec;
+  }
 
-    // for the pipe I have to take the input from the last command
-    // so I am redirecting the stdin to previous pipe.
-    if (strcmp(lastSpecialCharacter, "|") == 0)
+  if (isStale && isChanged && promptWorker.isStarted)
+  {
+    struct timespec limit;
+    clock_gettime(CLOCK_MONOTONIC, &limit);
+    int64_t limitNanos = limit.tv_nsec + PROMPT_WAIT_NANOS;
+    limit.tv_sec += limitNanos / 1000000000LL;
+    limit.tv_nsec = limitNanos % 1000000000LL;
+    while (isStale && pthread_cond_timedwait(&promptWorker.done, &promptWorker.lock, &limit) == 0)
     {
-      dup2(prev_pipeFD, STDIN_FILENO);
-      close(prev_pipeFD);
+      entry = yash_findPromptCacheEntry(directory);
+      isStale = entry == NULL || entry->updatedAt < lastCommandEnd;
     }
+    entry = yash_findPromptCacheEntry(directory);
+  }
+
+  snprintf(git, PROMPT_SEGMENT_SIZE, "%s", entry != NULL ? entry->git : "");
+  snprintf(load, PROMPT_SEGMENT_SIZE, "%s", promptWorker.load);
+  pthread_mutex_unlock(&promptWorker.lock);
+}
+
+/**
+ * @brief Function to display the custom shell prompt.
+ *
+ * The prompt is the template of YASH_PROMPT, or the default one with the letters 'yash'
+ * in different colors followed by a bug emoji and a '$' sign. The template is compiled
+ * once into segments and only compiled again when YASH_PROMPT changes.
+ *
+ * All the segments are written with one writev. The slow segments (git and load) come
+ * from the cache of the prompt worker, the prompt only waits for them a short bounded time
+ * when the directory is new or a command changed the repository.
+ * The written segments are kept so Ctrl-C can write the prompt again from its handler.
+ */
+void yash_prompt()
+{
+  const char *template = yash_getVariableText("YASH_PROMPT");
+  if (template[0] == '\0')
+  {
+    template = PROMPT_DEFAULT_TEMPLATE;
+  }
+
+  // the vector of the last prompt points in the literals which are freed when the
+  // template is compiled again, so it is emptied first with SIGINT blocked and
+  // Ctrl-C does not write it again until the new one is complete.
+  sigset_t interrupt;
+  sigset_t previousSignals;
+  sigemptyset(&interrupt);
+  sigaddset(&interrupt, SIGINT);
+  sigprocmask(SIG_BLOCK, &interrupt, &previousSignals);
+  promptVectorCount = 0;
+  sigprocmask(SIG_SETMASK, &previousSignals, NULL);
+
+  if (promptTemplate == NULL || strcmp(template, promptTemplate) != 0)
+  {
+    yash_compilePrompt(template);
+  }
+
+  char directory[PATH_MAX] = "";
+  char git[PROMPT_SEGMENT_SIZE] = "";
+  char load[PROMPT_SEGMENT_SIZE] = "";
+  if (getcwd(directory, sizeof(directory)) == NULL)
+  {
+    directory[0] = '\0';
+  }
+  if (promptHasWorkerSegment)
+  {
+    yash_readPromptCache(directory, git, load);
+  }
 
-    // for hash special character I am setting the position to null where the file list ends
-    if (strcmp(lastSpecialCharacter, "#") == 0 && lastHashReplacement != -1)
+  const char *home = getenv("HOME");
+  size_t homeLength = home != NULL ? strlen(home) : 0;
+  size_t used = 0;
+  int count = 0;
+  for (int index = 0; index < promptSegmentCount && count < PROMPT_MAX_SEGMENTS; index++)
+  {
+    const yash_promptSegment *segment = &promptSegments[index];
+    char *text = promptRendered + used;
+    size_t left = sizeof(promptRendered) - used;
+    int length = 0;
+
+    switch (segment->type)
     {
-      commandVector[lastHashReplacement + 1] = NULL;
+    case PROMPT_LITERAL:
+      promptVector[count++] = (struct iovec){promptLiterals + segment->offset, segment->length};
+      continue;
+    case PROMPT_DIRECTORY:
+      if (homeLength > 1 && strncmp(directory, home, homeLength) == 0 &&
+          (directory[homeLength] == '/' || directory[homeLength] == '\0'))
+      {
+        length = snprintf(text, left, "~%s", directory + homeLength);
+      }
+      else
+      {
+        length = snprintf(text, left, "%s", directory);
+      }
+      break;
+    case PROMPT_GIT:
+      length = snprintf(text, left, "%s", git);
+      break;
+    case PROMPT_STATUS:
+      length = lastExitStatus != 0 ? snprintf(text, left, " [%d]", lastExitStatus) : 0;
+      break;
+    case PROMPT_DURATION:
+      length = lastCommandNanos >= 1000000000LL ? snprintf(text, left, " %.1fs", lastCommandNanos / 1e9) : 0;
+      break;
+    case PROMPT_JOBS:
+      length = bgProcessListPointer >= 0 ? snprintf(text, left, " jobs:%d", bgProcessListPointer + 1) : 0;
+      break;
+    case PROMPT_LOAD:
+      length = snprintf(text, left, "%s", load);
+      break;
     }
 
-    // at last we want to see the output on terminal so
-    // I am redirecting the stdout to origin stdout which is the terminal.
-    if (dup2(original_stdout, STDOUT_FILENO) == -1)
+    if (length < 0 || left == 0)
+    {
+      length = 0;
+    }
+    else if ((size_t)length >= left)
+    {
+      length = left - 1;
+    }
+    if (length > 0)
     {
-      yash_logMessage("Error while reseting stdout");
-      exit(EXIT_FAILURE);
+      promptVector[count++] = (struct iovec){text, (size_t)length};
+      used += length;
     }
+  }
+
+  while (writev(STDOUT_FILENO, promptVector, count) == -1 && errno == EINTR)
+  {
+  }
+
+  // the fence keeps the stores of the vector before the count seen by the handler.
+  atomic_signal_fence(memory_order_release);
+  promptVectorCount = count;
+}
+
+// this is the function which execute the shell loop
+// it stays in loop for the time the shell is active
+// it prints the prompt and wait for the user input
+// and then act accordingly based on the input.
+void yash_loop()
+{
+
+  // here the shell loop starts
+  do
+  {
+
+    // I am using fflush to flush stdout before the prompt is written to its fd,
+    // stderr is not buffered and the commands write to their own fds.
+    fflush(stdout);
+
+    // init the variable to store input.
+    userPrompt = malloc(sizeof(char) * INPUT_BUFFER_SIZE);
 
-    // here i am executing the command.
-    yash_executeCommand(commandVector[0], commandVector, argsCount);
+    // this is the function used to write a shell specific prompt
+    // which tells the user that shell is asking for the prompt.
+    yash_prompt();
 
-    // further I am updating the pointers.
-    commandStartPointer = iterator + 1;
-    commandsCounter++;
+    // this function is used to get the prompt from the using from at the stdin stream.
+    // if the input is closed (Ctrl-D or end of piped input) the shell exits.
+    if (yash_readPrompt(&userPrompt) == -1)
+    {
+      yash_cleanUp();
+      break;
+    }
 
-    // at last I am reseting the stdin and stdout clearing the memory
-    // and closing any unused file descriptors.
-    if (dup2(original_stdin, STDIN_FILENO) == -1)
+    // now the prompt is parsed into the tree and executed, a syntax error
+    // is printed by the parser and nothing of the prompt is executed.
+    // the same parser and executor are used for script files.
+    // a command which is not complete continues on the next lines.
+    while (yash_runPrompt(userPrompt, 1) == -2)
     {
-      yash_logMessage("Error while reseting stdin");
-      exit(EXIT_FAILURE);
+      printf("> ");
+      fflush(stdout);
+
+      char line[INPUT_BUFFER_SIZE];
+      char *linePointer = line;
+      if (yash_readPrompt(&linePointer) == -1)
+      {
+        // at the end of the input the command is parsed once more to print the error.
+        yash_runPrompt(userPrompt, 0);
+        break;
+      }
+      size_t length = strlen(userPrompt);
+      userPrompt = realloc(userPrompt, length + strlen(line) + 2);
+      userPrompt[length] = '\n';
+      strcpy(userPrompt + length + 1, line);
     }
 
     yash_cleanUp();
@@ -867,6 +6953,7 @@ void yash_loop()
 // further it is also being used by the kill the latest bg process bring to foreground using fg
 void handleCtrlC()
 {
+  isLoopInterrupted = 1;
   if (isFgProcess == 1)
   {
     kill(bgProcessIds[bgProcessListPointer], SIGINT);
@@ -874,17 +6961,70 @@ void handleCtrlC()
 
     return;
   }
-  yash_logMessage("");
-  yash_prompt();
-  fflush(stdout);
+  // only write can be used here, the segments of the last prompt are written again.
+  if (write(STDOUT_FILENO, "\n", 1) == 1)
+  {
+    writev(STDOUT_FILENO, promptVector, promptVectorCount);
+  }
 }
 
 // this is the main driver function of the shell
-// it starts the shell loop
-// and set signals
+// it starts the shell loop and set signals, if a script file is
+// given it executes the script instead of asking for prompts.
+// usage: yash [--no-cache] [--audit FILE] [script]
+//        yash --bench-cache script [iterations]
+//        yash --audit-decode FILE [--json]
 int main(int argc, char const *argv[])
 {
-  // setting the signal handler
+  const char *scriptPath = NULL;
+  const char *auditPath = getenv("YASH_AUDIT_LOG");
+
+  if (getenv("YASH_NO_CACHE") != NULL)
+  {
+    isScriptCacheDisabled = 1;
+  }
+
+  for (int argument = 1; argument < argc; argument++)
+  {
+    if (strcmp(argv[argument], "--no-cache") == 0)
+    {
+      isScriptCacheDisabled = 1;
+    }
+    else if (strcmp(argv[argument], "--audit") == 0 && argument + 1 < argc)
+    {
+      auditPath = argv[argument + 1];
+      argument++;
+    }
+    else if (strcmp(argv[argument], "--audit-decode") == 0 && argument + 1 < argc)
+    {
+      int isJson = argument + 2 < argc && strcmp(argv[argument + 2], "--json") == 0;
+      return yash_auditDecode(argv[argument + 1], isJson);
+    }
+    else if (strcmp(argv[argument], "--bench-cache") == 0 && argument + 1 < argc)
+    {
+      long iterations = argument + 2 < argc ? atol(argv[argument + 2]) : 1000;
+      return yash_benchScriptCache(argv[argument + 1], iterations > 0 ? iterations : 1000);
+    }
+    else if (scriptPath == NULL)
+    {
+      scriptPath = argv[argument];
+    }
+  }
+
+  if (auditPath != NULL && auditPath[0] != '\0' && yash_auditStart(auditPath) == -1)
+  {
+    return EXIT_FAILURE;
+  }
+
+  // SIGTTOU is ignored so the shell can take the terminal back from a command
+  // running in its own process group, also when it runs a script.
+  signal(SIGTTOU, SIG_IGN);
+  if (scriptPath != NULL)
+  {
+    return yash_runScript(scriptPath);
+  }
+
+  // setting the signal handler.
   signal(SIGINT, handleCtrlC);
 
   // starting the shell loop.